@@ -0,0 +1,112 @@
+#include "base_stream.h"
+
+#include <google/protobuf/wire_format_lite.h>
+
+#include <algorithm>
+#include <climits>
+
+namespace serialization {
+
+    using google::protobuf::internal::WireFormatLite;
+
+    const int READ_CHUNK_SIZE = 1 << 30;
+    // A field starting within a chunk always fits in its stream.
+    const uint32_t MAX_FIELD_SIZE = INT_MAX - READ_CHUNK_SIZE;
+
+    BaseWriter::BaseWriter(std::ostream& out)
+        : stream_(&out)
+        , coded_(&stream_) {
+    }
+
+    void BaseWriter::WriteMessage(int field_number,
+        const google::protobuf::MessageLite& message) {
+
+        coded_.WriteTag(WireFormatLite::MakeTag(field_number,
+            WireFormatLite::WIRETYPE_LENGTH_DELIMITED));
+        coded_.WriteVarint32(static_cast<uint32_t>(message.ByteSizeLong()));
+        message.SerializeWithCachedSizes(&coded_);
+    }
+
+    void BaseWriter::WriteFixed64(int field_number, uint64_t value) {
+        coded_.WriteTag(WireFormatLite::MakeTag(field_number,
+            WireFormatLite::WIRETYPE_FIXED64));
+        coded_.WriteLittleEndian64(value);
+    }
+
+    uint64_t BaseWriter::GetByteCount() {
+        // The bytes the coded stream holds are handed back first.
+        coded_.Trim();
+        return static_cast<uint64_t>(stream_.ByteCount());
+    }
+
+    BaseReader::BaseReader(std::istream& in)
+        : BaseReader(in, NO_SIZE) {
+    }
+
+    BaseReader::BaseReader(std::istream& in, uint64_t size)
+        : stream_(&in)
+        , size_(size) {
+        StartChunk();
+    }
+
+    int BaseReader::NextField() {
+        if (coded_->CurrentPosition() > READ_CHUNK_SIZE) {
+            StartChunk();
+        }
+        tag_ = coded_->ReadTag();
+        if (tag_ == 0) {
+            is_at_end_ = coded_->ConsumedEntireMessage() &&
+                (size_ == NO_SIZE ||
+                 static_cast<uint64_t>(coded_->CurrentPosition()) == size_);
+            return 0;
+        }
+        return WireFormatLite::GetTagFieldNumber(tag_);
+    }
+
+    bool BaseReader::ReadMessage(google::protobuf::MessageLite& message) {
+        uint32_t size = 0;
+        if (WireFormatLite::GetTagWireType(tag_) !=
+                WireFormatLite::WIRETYPE_LENGTH_DELIMITED ||
+            !coded_->ReadVarint32(&size) || size > MAX_FIELD_SIZE) {
+            return false;
+        }
+        const auto limit = coded_->PushLimit(static_cast<int>(size));
+        message.Clear();
+        const bool is_read = message.MergeFromCodedStream(&*coded_) &&
+            coded_->BytesUntilLimit() == 0;
+        coded_->PopLimit(limit);
+        return is_read;
+    }
+
+    bool BaseReader::ReadFixed64(uint64_t& value) {
+        return WireFormatLite::GetTagWireType(tag_) ==
+                WireFormatLite::WIRETYPE_FIXED64 &&
+            coded_->ReadLittleEndian64(&value);
+    }
+
+    bool BaseReader::SkipField() {
+        return WireFormatLite::SkipField(&*coded_, tag_);
+    }
+
+    bool BaseReader::IsAtEnd() const {
+        return is_at_end_;
+    }
+
+    // private:
+
+    void BaseReader::StartChunk() {
+        if (coded_) {
+            if (size_ != NO_SIZE) {
+                size_ -= static_cast<uint64_t>(coded_->CurrentPosition());
+            }
+            // Hands the bytes read ahead back to stream_.
+            coded_.reset();
+        }
+        coded_.emplace(&stream_);
+        if (size_ != NO_SIZE) {
+            coded_->PushLimit(static_cast<int>(
+                std::min<uint64_t>(size_, INT_MAX)));
+        }
+    }
+
+} // namespace serialization
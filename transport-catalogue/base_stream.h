@@ -0,0 +1,75 @@
+#pragma once
+
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/io/zero_copy_stream_impl.h>
+#include <google/protobuf/message_lite.h>
+
+#include <cstdint>
+#include <istream>
+#include <limits>
+#include <optional>
+#include <ostream>
+
+namespace serialization {
+
+    // Writes a message field by field: every element of a repeated
+    // field is a length-delimited record of its own, so only one of
+    // them is kept in memory at a time. Fields written one after
+    // another read back as one message, and a non-repeated message
+    // field written several times reads back as their merge.
+    class BaseWriter {
+    public:
+        explicit BaseWriter(std::ostream& out);
+
+        void WriteMessage(int field_number,
+                          const google::protobuf::MessageLite& message);
+        void WriteFixed64(int field_number, uint64_t value);
+
+        // Bytes written so far, counted in 64 bits: CodedOutputStream
+        // counts in an int.
+        uint64_t GetByteCount();
+
+    private:
+        google::protobuf::io::OstreamOutputStream stream_;
+        google::protobuf::io::CodedOutputStream coded_;
+    };
+
+    // Reads what BaseWriter writes, or any serialized message, field
+    // by field. A CodedInputStream reads at most 2 GB, so a new one is
+    // started every READ_CHUNK_SIZE bytes or so, at a field boundary;
+    // a single field over MAX_FIELD_SIZE is taken as damaged.
+    class BaseReader {
+    public:
+        explicit BaseReader(std::istream& in);
+        // Reads only the next `size` bytes.
+        BaseReader(std::istream& in, uint64_t size);
+
+        // Number of the next field, 0 at the end of the input or
+        // where it is damaged.
+        int NextField();
+
+        // Read the value of the field NextField returned. False if it
+        // has another type or is damaged.
+        bool ReadMessage(google::protobuf::MessageLite& message);
+        bool ReadFixed64(uint64_t& value);
+        bool SkipField();
+
+        // Whether the input ended where a field could start.
+        bool IsAtEnd() const;
+
+    private:
+        static constexpr uint64_t NO_SIZE =
+            std::numeric_limits<uint64_t>::max();
+
+        google::protobuf::io::IstreamInputStream stream_;
+        std::optional<google::protobuf::io::CodedInputStream> coded_;
+        // Bytes left for coded_ when it was started, NO_SIZE if the
+        // input is read to its end.
+        uint64_t size_ = NO_SIZE;
+        uint32_t tag_ = 0;
+        bool is_at_end_ = false;
+
+        void StartChunk();
+    };
+
+} // namespace serialization
@@ -0,0 +1,276 @@
+#include "catalogue_builder.h"
+
+#include <algorithm>
+
+namespace cat {
+
+    using namespace std::string_literals;
+
+    void CatalogueBuilder::Reserve(size_t stops_count,
+        size_t distances_count, size_t buses_count,
+        size_t route_stops_count) {
+
+        stops_.reserve(stops_count);
+        is_added_.reserve(stops_count);
+        stops_map_.reserve(stops_count);
+        distances_.reserve(distances_count);
+        buses_.reserve(buses_count);
+        route_offsets_.reserve(buses_count + 1);
+        route_stops_.reserve(route_stops_count);
+    }
+
+    dom::StopId CatalogueBuilder::AddStop(std::string_view stop_name,
+        double latitude, double longitude) {
+
+        const auto id = GetStopId(stop_name);
+        stops_[id].latitude = latitude;
+        stops_[id].longitude = longitude;
+        const auto prepared = geo::Prepare({ latitude, longitude });
+        stops_[id].sin_lat = prepared.sin_lat;
+        stops_[id].cos_lat = prepared.cos_lat;
+        is_added_[id] = true;
+        return id;
+    }
+
+    void CatalogueBuilder::AddStops(const std::vector<dom::Stop>& stops) {
+        for (const auto& stop : stops) {
+            AddStop(stop.name, stop.latitude, stop.longitude);
+        }
+    }
+
+    void CatalogueBuilder::AddStopDistance(std::string_view from_stop,
+        std::string_view to_stop, int distance) {
+
+        const auto from = GetStopId(from_stop);
+        distances_.push_back({ from, GetStopId(to_stop), distance });
+    }
+
+    void CatalogueBuilder::AddStopDistance(dom::StopId from_stop,
+        dom::StopId to_stop, int distance) {
+
+        if (from_stop >= stops_.size() || to_stop >= stops_.size()) {
+            throw std::invalid_argument("Invalid Stop in Distances"s);
+        }
+        distances_.push_back({ from_stop, to_stop, distance });
+    }
+
+    void CatalogueBuilder::AddStopDistances(
+        const std::vector<StopsDistance>& stops_distances) {
+
+        distances_.reserve(distances_.size() + stops_distances.size());
+        for (const auto& value : stops_distances) {
+            AddStopDistance(value.from_stop, value.to_stop,
+                            value.distance);
+        }
+    }
+
+    bool CatalogueBuilder::HasStop(std::string_view stop_name) const {
+        const auto it = stops_map_.find(stop_name);
+        return it != stops_map_.end() && is_added_[it->second];
+    }
+
+    std::string_view CatalogueBuilder::GetStopName(
+        dom::StopId stop_id) const {
+        return stops_[stop_id].name;
+    }
+
+    void CatalogueBuilder::RemoveStop(std::string_view stop_name) {
+        const auto it = stops_map_.find(stop_name);
+        if (it == stops_map_.end()) {
+            return;
+        }
+        const auto id = it->second;
+        is_added_[id] = false;
+
+        distances_.erase(std::remove_if(distances_.begin(),
+            distances_.end(), [id](const Distance& distance) {
+                return distance.from == id || distance.to == id;
+            }), distances_.end());
+
+        uint32_t size = 0;
+        uint32_t begin = route_offsets_.front();
+        for (size_t i = 1; i < route_offsets_.size(); ++i) {
+            const uint32_t end = route_offsets_[i];
+            for (uint32_t j = begin; j < end; ++j) {
+                if (route_stops_[j] != id) {
+                    route_stops_[size++] = route_stops_[j];
+                }
+            }
+            route_offsets_[i] = size;
+            begin = end;
+        }
+        route_stops_.resize(size);
+        EraseShortRoutes();
+    }
+
+    void CatalogueBuilder::RemoveStopDistance(std::string_view from_stop,
+        std::string_view to_stop) {
+
+        const auto from = stops_map_.find(from_stop);
+        const auto to = stops_map_.find(to_stop);
+        if (from == stops_map_.end() || to == stops_map_.end()) {
+            return;
+        }
+        distances_.erase(std::remove_if(distances_.begin(),
+            distances_.end(), [&](const Distance& distance) {
+                return distance.from == from->second &&
+                    distance.to == to->second;
+            }), distances_.end());
+    }
+
+    dom::BusId CatalogueBuilder::AddBus(std::string_view bus_name,
+        bool is_annular, const std::vector<dom::Headway>& headways) {
+
+        RemoveBus(bus_name);
+
+        dom::Bus bus;
+        bus.name = names_.Store(bus_name);
+        bus.is_annular = is_annular;
+        bus.headways = headways;
+        bus.id = static_cast<dom::BusId>(buses_.size());
+        buses_map_[bus.name] = bus.id;
+        buses_.push_back(std::move(bus));
+        route_offsets_.push_back(route_offsets_.back());
+        return buses_.back().id;
+    }
+
+    void CatalogueBuilder::AddBusStop(std::string_view stop_name) {
+        route_stops_.push_back(GetStopId(stop_name));
+        ++route_offsets_.back();
+    }
+
+    void CatalogueBuilder::AddBusStop(dom::StopId stop_id) {
+        if (stop_id >= stops_.size()) {
+            throw std::invalid_argument("Invalid Stop in Bus"s);
+        }
+        route_stops_.push_back(stop_id);
+        ++route_offsets_.back();
+    }
+
+    void CatalogueBuilder::RemoveBus(std::string_view bus_name) {
+        const auto it = buses_map_.find(bus_name);
+        if (it == buses_map_.end()) {
+            return;
+        }
+        const auto id = it->second;
+        buses_map_.erase(it);
+
+        const uint32_t begin = route_offsets_[id];
+        const uint32_t count = route_offsets_[id + 1] - begin;
+        route_stops_.erase(route_stops_.begin() + begin,
+                           route_stops_.begin() + begin + count);
+        route_offsets_.erase(route_offsets_.begin() + id + 1);
+        for (size_t i = id + 1; i < route_offsets_.size(); ++i) {
+            route_offsets_[i] -= count;
+        }
+
+        buses_.erase(buses_.begin() + id);
+        for (size_t i = id; i < buses_.size(); ++i) {
+            buses_[i].id = static_cast<dom::BusId>(i);
+            buses_map_[buses_[i].name] = buses_[i].id;
+        }
+    }
+
+    void CatalogueBuilder::SetBusStats(dom::BusId bus_id,
+        const dom::BusStats& stats) {
+        buses_[bus_id].stats = stats;
+    }
+
+    TransportCatalogue CatalogueBuilder::Freeze() {
+        for (const auto& distance : distances_) {
+            if (!is_added_[distance.from] || !is_added_[distance.to]) {
+                throw std::invalid_argument(
+                    "Invalid Stop in Distances"s);
+            }
+        }
+        for (const auto stop : route_stops_) {
+            if (!is_added_[stop]) {
+                throw std::invalid_argument("Invalid Stop in Bus"s);
+            }
+        }
+        EraseShortRoutes();
+        EraseRemovedStops();
+
+        TransportCatalogue db;
+        db.names_ = std::move(names_);
+        db.stops_ = std::move(stops_);
+        db.stops_map_ = std::move(stops_map_);
+        db.buses_ = std::move(buses_);
+        db.route_stops_ = std::move(route_stops_);
+        db.route_offsets_ = std::move(route_offsets_);
+
+        db.distances_.Reserve(distances_.size());
+        for (const auto& distance : distances_) {
+            db.distances_.Set(distance.from, distance.to,
+                              distance.distance);
+        }
+
+        db.Finalize();
+
+        *this = CatalogueBuilder();
+        return db;
+    }
+
+    // private:
+
+    dom::StopId CatalogueBuilder::GetStopId(std::string_view stop_name) {
+        const auto it = stops_map_.find(stop_name);
+        if (it != stops_map_.end()) {
+            return it->second;
+        }
+
+        dom::Stop stop;
+        stop.name = names_.Store(stop_name);
+        stop.id = static_cast<dom::StopId>(stops_.size());
+        stops_.push_back(stop);
+        is_added_.push_back(false);
+        stops_map_[stop.name] = stop.id;
+        return stop.id;
+    }
+
+    void CatalogueBuilder::EraseRemovedStops() {
+        // Stops not added are not referred to by now: they are the
+        // ones removed.
+        if (std::find(is_added_.begin(), is_added_.end(), false) ==
+            is_added_.end()) {
+            return;
+        }
+
+        std::vector<dom::StopId> new_ids(stops_.size());
+        size_t size = 0;
+        for (size_t i = 0; i < stops_.size(); ++i) {
+            if (!is_added_[i]) {
+                stops_map_.erase(stops_[i].name);
+                continue;
+            }
+            new_ids[i] = static_cast<dom::StopId>(size);
+            stops_[size] = stops_[i];
+            stops_[size].id = new_ids[i];
+            stops_map_[stops_[size].name] = new_ids[i];
+            ++size;
+        }
+        stops_.resize(size);
+        is_added_.assign(size, true);
+
+        for (auto& distance : distances_) {
+            distance.from = new_ids[distance.from];
+            distance.to = new_ids[distance.to];
+        }
+        for (auto& stop : route_stops_) {
+            stop = new_ids[stop];
+        }
+    }
+
+    void CatalogueBuilder::EraseShortRoutes() {
+        std::vector<std::string_view> bus_names;
+        for (const auto& bus : buses_) {
+            if (route_offsets_[bus.id + 1] - route_offsets_[bus.id] < 2) {
+                bus_names.push_back(bus.name);
+            }
+        }
+        for (const auto bus_name : bus_names) {
+            RemoveBus(bus_name);
+        }
+    }
+
+} // namespace cat
@@ -0,0 +1,92 @@
+#pragma once
+
+#include "transport_catalogue.h"
+
+#include <string_view>
+#include <vector>
+
+namespace cat {
+
+    struct StopsDistance {
+        std::string_view from_stop;
+        std::string_view to_stop;
+        int distance;
+    };
+
+    // Collects a base and freezes it into a TransportCatalogue.
+    // Stops may be referred to before they are added: names are
+    // checked all at once by Freeze(), which then builds every index
+    // of the catalogue together.
+    class CatalogueBuilder {
+    public:
+        CatalogueBuilder() = default;
+
+        void Reserve(size_t stops_count, size_t distances_count,
+                     size_t buses_count, size_t route_stops_count);
+
+        dom::StopId AddStop(std::string_view stop_name,
+                            double latitude, double longitude);
+        void AddStops(const std::vector<dom::Stop>& stops);
+
+        void AddStopDistance(std::string_view from_stop,
+                             std::string_view to_stop, int distance);
+        // By the ids AddStop returned; throws std::invalid_argument
+        // for other ids.
+        void AddStopDistance(dom::StopId from_stop, dom::StopId to_stop,
+                             int distance);
+        void AddStopDistances(
+            const std::vector<StopsDistance>& stops_distances);
+
+        bool HasStop(std::string_view stop_name) const;
+        // Stays valid in the catalogue the builder makes.
+        std::string_view GetStopName(dom::StopId stop_id) const;
+        // Takes the stop out of the routes and the distances as well;
+        // a bus left with fewer than two stops is removed.
+        void RemoveStop(std::string_view stop_name);
+        // Only the distance given in this direction.
+        void RemoveStopDistance(std::string_view from_stop,
+                                std::string_view to_stop);
+
+        // Stops of the bus follow by AddBusStop. A bus of the same name
+        // added before is replaced.
+        dom::BusId AddBus(std::string_view bus_name, bool is_annular,
+                          const std::vector<dom::Headway>& headways = {});
+        void AddBusStop(std::string_view stop_name);
+        void AddBusStop(dom::StopId stop_id);
+        void RemoveBus(std::string_view bus_name);
+
+        // Statistics restored from a base; the catalogue computes
+        // them for the buses which have none.
+        void SetBusStats(dom::BusId bus_id, const dom::BusStats& stats);
+
+        // Throws std::invalid_argument if a stop referred to by the
+        // distances or the buses is not added. Buses with fewer than
+        // two stops are left out. The builder is empty afterwards.
+        TransportCatalogue Freeze();
+
+    private:
+        struct Distance {
+            dom::StopId from = 0;
+            dom::StopId to = 0;
+            int distance = 0;
+        };
+
+        StringPool names_;
+        std::vector<dom::Stop> stops_;
+        std::vector<bool> is_added_;
+        std::unordered_map<std::string_view, dom::StopId> stops_map_;
+        std::vector<Distance> distances_;
+        std::vector<dom::Bus> buses_;
+        std::unordered_map<std::string_view, dom::BusId> buses_map_;
+        std::vector<dom::StopId> route_stops_;
+        std::vector<uint32_t> route_offsets_ = { 0 };
+
+        dom::StopId GetStopId(std::string_view stop_name);
+        // Drops the stops removed, renumbering the rest.
+        void EraseRemovedStops();
+        // Removes the buses with fewer than two stops, which go
+        // nowhere and have no length.
+        void EraseShortRoutes();
+    };
+
+} // namespace cat
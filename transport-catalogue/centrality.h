@@ -0,0 +1,224 @@
+#pragma once
+
+#include "graph.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <queue>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+    // Per-vertex scores of a graph: betweenness centrality (the number
+    // of shortest paths between other vertices passing the vertex,
+    // split evenly between equal paths) and the mean weight of the
+    // shortest paths from the vertex to the vertices it reaches.
+    // A path passes the inner vertices of its edges too, when the
+    // edges have any (see ComputeCentrality).
+    struct Centrality {
+        std::vector<double> betweenness;
+        std::vector<double> mean_weight;
+        std::vector<uint32_t> reachable_count;
+
+        bool IsEmpty() const {
+            return betweenness.empty();
+        }
+
+        void Clear() {
+            betweenness.clear();
+            mean_weight.clear();
+            reachable_count.clear();
+        }
+    };
+
+    // Edges with no inner vertices.
+    struct NoInnerVertices {
+        template <typename Visit>
+        void operator()(EdgeId, Visit&&) const {
+        }
+    };
+
+    namespace detail {
+
+        // Search state of one worker, reused from source to source.
+        template <typename Weight, typename ForEachInner>
+        class BrandesWorker {
+        public:
+            BrandesWorker(const DirectedWeightedGraph<Weight>& graph,
+                          const ForEachInner& for_each_inner)
+                : graph_(graph)
+                , for_each_inner_(for_each_inner)
+                , weights_(graph.GetVertexCount())
+                , paths_(graph.GetVertexCount(), 0.0)
+                , dependencies_(graph.GetVertexCount(), 0.0)
+                , predecessors_(graph.GetVertexCount())
+                , betweenness_(graph.GetVertexCount(), 0.0) {
+            }
+
+            // Runs Dijkstra from the source, then adds the
+            // dependencies of the source on the other vertices to the
+            // worker's own betweenness.
+            void Accumulate(VertexId source, Centrality& result) {
+                using QueueItem = std::pair<Weight, VertexId>;
+                std::priority_queue<QueueItem, std::vector<QueueItem>,
+                                    std::greater<QueueItem>> queue;
+
+                // Every vertex reached is settled, so resetting these
+                // clears all the previous search.
+                for (const VertexId vertex : settled_) {
+                    weights_[vertex] = std::nullopt;
+                    paths_[vertex] = 0.0;
+                    dependencies_[vertex] = 0.0;
+                    predecessors_[vertex].clear();
+                }
+                settled_.clear();
+
+                weights_[source] = Weight{};
+                paths_[source] = 1.0;
+                queue.push({ Weight{}, source });
+                while (!queue.empty()) {
+                    const auto [weight, vertex] = queue.top();
+                    queue.pop();
+                    if (*weights_[vertex] < weight) {
+                        continue;
+                    }
+                    settled_.push_back(vertex);
+                    for (const EdgeId edge_id :
+                         graph_.GetIncidentEdges(vertex)) {
+                        const auto& edge = graph_.GetEdge(edge_id);
+                        const Weight candidate = weight + edge.weight;
+                        auto& to_weight = weights_[edge.to];
+                        if (!to_weight || candidate < *to_weight) {
+                            to_weight = candidate;
+                            paths_[edge.to] = paths_[vertex];
+                            predecessors_[edge.to].assign(1, edge_id);
+                            queue.push({ candidate, edge.to });
+                        }
+                        else if (candidate == *to_weight) {
+                            paths_[edge.to] += paths_[vertex];
+                            predecessors_[edge.to].push_back(edge_id);
+                        }
+                    }
+                }
+
+                Weight total{};
+                for (const VertexId vertex : settled_) {
+                    total += *weights_[vertex];
+                }
+                const auto reachable =
+                    static_cast<uint32_t>(settled_.size() - 1);
+                result.reachable_count[source] = reachable;
+                result.mean_weight[source] = reachable > 0
+                    ? static_cast<double>(total) / reachable : 0.0;
+
+                for (auto it = settled_.rbegin(); it != settled_.rend();
+                     ++it) {
+                    const VertexId vertex = *it;
+                    const double share =
+                        (1.0 + dependencies_[vertex]) / paths_[vertex];
+                    // The paths along an edge pass its inner
+                    // vertices as well, bar the ends of the search.
+                    for (const EdgeId edge_id : predecessors_[vertex]) {
+                        const VertexId predecessor =
+                            graph_.GetEdge(edge_id).from;
+                        const double flow = paths_[predecessor] * share;
+                        dependencies_[predecessor] += flow;
+                        for_each_inner_(edge_id, [&](VertexId inner) {
+                            if (inner != source && inner != vertex) {
+                                betweenness_[inner] += flow;
+                            }
+                        });
+                    }
+                    if (vertex != source) {
+                        betweenness_[vertex] += dependencies_[vertex];
+                    }
+                }
+            }
+
+            const std::vector<double>& GetBetweenness() const {
+                return betweenness_;
+            }
+
+        private:
+            const DirectedWeightedGraph<Weight>& graph_;
+            const ForEachInner& for_each_inner_;
+            std::vector<std::optional<Weight>> weights_;
+            std::vector<double> paths_;
+            std::vector<double> dependencies_;
+            // Edges along which the vertex is reached.
+            std::vector<std::vector<EdgeId>> predecessors_;
+            std::vector<VertexId> settled_;
+            std::vector<double> betweenness_;
+        };
+
+    } // namespace detail
+
+    // Brandes' algorithm with one Dijkstra search per source. Sources
+    // are handed out to `threads_count` workers one by one; each
+    // worker accumulates betweenness on its own and the totals are
+    // summed once all of them are done.
+    //
+    // An edge may stand for a walk through other vertices, as a bus
+    // ride does through the stops between those it joins:
+    // `for_each_inner(edge_id, visit)` calls `visit(vertex)` for each
+    // of them, and they are credited with the paths along the edge.
+    template <typename Weight, typename ForEachInner = NoInnerVertices>
+    Centrality ComputeCentrality(const DirectedWeightedGraph<Weight>& graph,
+                                 size_t threads_count = 0,
+                                 const ForEachInner& for_each_inner = {}) {
+        const size_t vertex_count = graph.GetVertexCount();
+        Centrality result;
+        result.betweenness.assign(vertex_count, 0.0);
+        result.mean_weight.assign(vertex_count, 0.0);
+        result.reachable_count.assign(vertex_count, 0);
+        if (vertex_count == 0) {
+            return result;
+        }
+
+        if (threads_count == 0) {
+            threads_count = std::max(1u, std::thread::hardware_concurrency());
+        }
+        threads_count = std::min(threads_count, vertex_count);
+
+        using Worker = detail::BrandesWorker<Weight, ForEachInner>;
+        std::vector<Worker> workers;
+        workers.reserve(threads_count);
+        for (size_t i = 0; i < threads_count; ++i) {
+            workers.emplace_back(graph, for_each_inner);
+        }
+
+        // Workers write the mean weights and counts of their own
+        // sources only.
+        std::atomic<size_t> next_source{ 0 };
+        auto work = [&](Worker& worker) {
+            for (size_t source = next_source++; source < vertex_count;
+                 source = next_source++) {
+                worker.Accumulate(static_cast<VertexId>(source), result);
+            }
+        };
+
+        std::vector<std::thread> threads;
+        threads.reserve(threads_count - 1);
+        for (size_t i = 1; i < threads_count; ++i) {
+            threads.emplace_back(work, std::ref(workers[i]));
+        }
+        work(workers[0]);
+        for (auto& thread : threads) {
+            thread.join();
+        }
+
+        for (const auto& worker : workers) {
+            const auto& betweenness = worker.GetBetweenness();
+            for (size_t i = 0; i < vertex_count; ++i) {
+                result.betweenness[i] += betweenness[i];
+            }
+        }
+        return result;
+    }
+
+} // namespace graph
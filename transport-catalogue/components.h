@@ -0,0 +1,195 @@
+#pragma once
+
+#include "graph.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <numeric>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+    // Connectivity of a graph: strong and weak components of every
+    // vertex plus reachability between strong components.
+    struct Components {
+        // Reachability closure is kept only up to this number of
+        // strong components: it takes count^2 bits.
+        static constexpr size_t MAX_CLOSURE_SIZE = 4096;
+        static constexpr size_t WORD_BITS = 64;
+
+        std::vector<uint32_t> strong;
+        std::vector<uint32_t> weak;
+        size_t strong_count = 0;
+        size_t weak_count = 0;
+        // A row of strong_count bits per strong component.
+        std::vector<uint64_t> closure;
+
+        bool IsEmpty() const {
+            return strong.empty();
+        }
+
+        size_t GetWordsPerRow() const {
+            return (strong_count + WORD_BITS - 1) / WORD_BITS;
+        }
+
+        // False only if there is surely no path from one vertex to the
+        // other. Without the closure vertices of one weak component
+        // are considered reachable.
+        bool IsReachable(VertexId from, VertexId to) const {
+            if (strong.empty()) {
+                return true;
+            }
+            if (strong[from] == strong[to]) {
+                return true;
+            }
+            if (weak[from] != weak[to]) {
+                return false;
+            }
+            if (closure.empty()) {
+                return true;
+            }
+            const size_t bit = strong[to];
+            return (closure[strong[from] * GetWordsPerRow() +
+                            bit / WORD_BITS] >>
+                    (bit % WORD_BITS)) & 1;
+        }
+
+        void Clear() {
+            strong.clear();
+            weak.clear();
+            closure.clear();
+            strong_count = 0;
+            weak_count = 0;
+        }
+    };
+
+    // Tarjan's algorithm (without recursion) for strong components and
+    // union-find for weak ones. Tarjan numbers strong components in
+    // reverse topological order, so the closure is filled in one pass.
+    template <typename Weight>
+    Components FindComponents(const DirectedWeightedGraph<Weight>& graph) {
+        const size_t vertex_count = graph.GetVertexCount();
+        constexpr uint32_t UNVISITED = UINT32_MAX;
+
+        Components components;
+        components.strong.assign(vertex_count, UNVISITED);
+
+        std::vector<uint32_t> index(vertex_count, UNVISITED);
+        std::vector<uint32_t> low_link(vertex_count, 0);
+        std::vector<bool> on_stack(vertex_count, false);
+        std::vector<VertexId> stack;
+        // Vertex and the position in its incidence list.
+        std::vector<std::pair<VertexId, size_t>> call_stack;
+        uint32_t next_index = 0;
+
+        for (VertexId root = 0; root < vertex_count; ++root) {
+            if (index[root] != UNVISITED) {
+                continue;
+            }
+            call_stack.push_back({ root, 0 });
+            while (!call_stack.empty()) {
+                auto& [vertex, position] = call_stack.back();
+                if (position == 0 && index[vertex] == UNVISITED) {
+                    index[vertex] = low_link[vertex] = next_index++;
+                    stack.push_back(vertex);
+                    on_stack[vertex] = true;
+                }
+                const auto& edges =
+                    graph.GetIncidenceLists()[vertex];
+                if (position < edges.size()) {
+                    const VertexId to =
+                        graph.GetEdge(edges[position++]).to;
+                    if (index[to] == UNVISITED) {
+                        call_stack.push_back({ to, 0 });
+                    }
+                    else if (on_stack[to]) {
+                        low_link[vertex] =
+                            std::min(low_link[vertex], index[to]);
+                    }
+                    continue;
+                }
+
+                const VertexId done = vertex;
+                call_stack.pop_back();
+                if (!call_stack.empty()) {
+                    const VertexId parent = call_stack.back().first;
+                    low_link[parent] =
+                        std::min(low_link[parent], low_link[done]);
+                }
+                if (low_link[done] == index[done]) {
+                    const auto component =
+                        static_cast<uint32_t>(components.strong_count++);
+                    VertexId member;
+                    do {
+                        member = stack.back();
+                        stack.pop_back();
+                        on_stack[member] = false;
+                        components.strong[member] = component;
+                    } while (member != done);
+                }
+            }
+        }
+
+        std::vector<VertexId> parent(vertex_count);
+        std::iota(parent.begin(), parent.end(), 0);
+        auto find_root = [&parent](VertexId vertex) {
+            while (parent[vertex] != vertex) {
+                vertex = parent[vertex] = parent[parent[vertex]];
+            }
+            return vertex;
+        };
+        for (const auto& edge : graph.GetEdges()) {
+            const VertexId from = find_root(edge.from);
+            const VertexId to = find_root(edge.to);
+            if (from != to) {
+                parent[std::max(from, to)] = std::min(from, to);
+            }
+        }
+        components.weak.assign(vertex_count, 0);
+        std::vector<uint32_t> weak_ids(vertex_count, UNVISITED);
+        for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+            auto& weak_id = weak_ids[find_root(vertex)];
+            if (weak_id == UNVISITED) {
+                weak_id = static_cast<uint32_t>(components.weak_count++);
+            }
+            components.weak[vertex] = weak_id;
+        }
+
+        if (components.strong_count > Components::MAX_CLOSURE_SIZE) {
+            return components;
+        }
+
+        const size_t words = components.GetWordsPerRow();
+        auto& closure = components.closure;
+        closure.assign(components.strong_count * words, 0);
+        std::vector<std::vector<VertexId>> members(
+            components.strong_count);
+        for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+            members[components.strong[vertex]].push_back(vertex);
+        }
+        for (size_t component = 0; component < components.strong_count;
+             ++component) {
+            uint64_t* row = &closure[component * words];
+            row[component / Components::WORD_BITS] |=
+                uint64_t{ 1 } << (component % Components::WORD_BITS);
+            for (const VertexId vertex : members[component]) {
+                for (const EdgeId edge_id :
+                     graph.GetIncidentEdges(vertex)) {
+                    const size_t to =
+                        components.strong[graph.GetEdge(edge_id).to];
+                    if (to == component) {
+                        continue;
+                    }
+                    const uint64_t* to_row = &closure[to * words];
+                    for (size_t word = 0; word < words; ++word) {
+                        row[word] |= to_row[word];
+                    }
+                }
+            }
+        }
+
+        return components;
+    }
+
+} // namespace graph
@@ -0,0 +1,238 @@
+#pragma once
+
+#include "graph.h"
+
+#include <algorithm>
+#include <functional>
+#include <optional>
+#include <queue>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+    // On-demand shortest path search. Unlike Router it keeps no
+    // precomputed tables: every query runs Dijkstra over the graph.
+    template <typename Weight>
+    class DijkstraRouter {
+    private:
+        using Graph = DirectedWeightedGraph<Weight>;
+
+    public:
+        explicit DijkstraRouter(const Graph& graph);
+
+        // A vertex together with the weight of reaching it from
+        // outside of the graph (for a source) or of leaving the graph
+        // from it (for a target).
+        struct Terminal {
+            VertexId vertex;
+            Weight weight;
+        };
+
+        struct RouteInfo {
+            Weight weight;
+            VertexId source;
+            VertexId target;
+            std::vector<EdgeId> edges;
+        };
+
+        // One search from all the sources at once. It stops as soon as
+        // no unsettled vertex can improve the best target found.
+        std::optional<RouteInfo> BuildRoute(
+            const std::vector<Terminal>& sources,
+            const std::vector<Terminal>& targets) const;
+
+        // The same avoiding the edges for which `is_open` is false.
+        template <typename EdgeFilter>
+        std::optional<RouteInfo> BuildRoute(
+            const std::vector<Terminal>& sources,
+            const std::vector<Terminal>& targets,
+            const EdgeFilter& is_open) const;
+
+        // Weights of the shortest paths from the sources to each of
+        // `targets`, none for the unreachable ones. The search stops
+        // when all the targets are settled.
+        template <typename EdgeFilter>
+        std::vector<std::optional<Weight>> ComputeWeights(
+            const std::vector<Terminal>& sources,
+            const std::vector<VertexId>& targets,
+            const EdgeFilter& is_open) const;
+
+    private:
+        struct QueueItem {
+            Weight weight;
+            VertexId vertex;
+            bool operator>(const QueueItem& other) const {
+                return weight > other.weight;
+            }
+        };
+
+        const Graph& graph_;
+    };
+
+    template <typename Weight>
+    DijkstraRouter<Weight>::DijkstraRouter(const Graph& graph)
+        : graph_(graph)
+    {}
+
+    template <typename Weight>
+    std::optional<typename DijkstraRouter<Weight>::RouteInfo>
+        DijkstraRouter<Weight>::BuildRoute(
+            const std::vector<Terminal>& sources,
+            const std::vector<Terminal>& targets) const {
+
+        return BuildRoute(sources, targets,
+                          [](EdgeId) { return true; });
+    }
+
+    template <typename Weight>
+    template <typename EdgeFilter>
+    std::optional<typename DijkstraRouter<Weight>::RouteInfo>
+        DijkstraRouter<Weight>::BuildRoute(
+            const std::vector<Terminal>& sources,
+            const std::vector<Terminal>& targets,
+            const EdgeFilter& is_open) const {
+
+        const size_t vertex_count = graph_.GetVertexCount();
+        std::vector<std::optional<Weight>> weights(vertex_count);
+        std::vector<std::optional<EdgeId>> prev_edges(vertex_count);
+        std::vector<std::optional<Weight>> exits(vertex_count);
+        std::priority_queue<QueueItem, std::vector<QueueItem>,
+                            std::greater<QueueItem>> queue;
+
+        for (const auto& target : targets) {
+            auto& exit = exits.at(target.vertex);
+            if (!exit || target.weight < *exit) {
+                exit = target.weight;
+            }
+        }
+        for (const auto& source : sources) {
+            auto& weight = weights.at(source.vertex);
+            if (!weight || source.weight < *weight) {
+                weight = source.weight;
+                queue.push({ source.weight, source.vertex });
+            }
+        }
+
+        std::optional<Weight> best_weight;
+        VertexId best_target = 0;
+        while (!queue.empty()) {
+            const QueueItem item = queue.top();
+            queue.pop();
+            if (best_weight && !(item.weight < *best_weight)) {
+                break;
+            }
+            if (*weights[item.vertex] < item.weight) {
+                continue;
+            }
+            if (const auto& exit = exits[item.vertex]) {
+                const Weight candidate = item.weight + *exit;
+                if (!best_weight || candidate < *best_weight) {
+                    best_weight = candidate;
+                    best_target = item.vertex;
+                }
+            }
+            for (const EdgeId edge_id :
+                 graph_.GetIncidentEdges(item.vertex)) {
+                if (!is_open(edge_id)) {
+                    continue;
+                }
+                const auto& edge = graph_.GetEdge(edge_id);
+                if (edge.weight < Weight{}) {
+                    throw std::domain_error(
+                        "Edges' weights should be non-negative");
+                }
+                const Weight candidate = item.weight + edge.weight;
+                auto& weight = weights[edge.to];
+                if (!weight || candidate < *weight) {
+                    weight = candidate;
+                    prev_edges[edge.to] = edge_id;
+                    queue.push({ candidate, edge.to });
+                }
+            }
+        }
+
+        if (!best_weight) {
+            return std::nullopt;
+        }
+
+        std::vector<EdgeId> edges;
+        VertexId vertex = best_target;
+        while (prev_edges[vertex]) {
+            edges.push_back(*prev_edges[vertex]);
+            vertex = graph_.GetEdge(*prev_edges[vertex]).from;
+        }
+        std::reverse(edges.begin(), edges.end());
+
+        return RouteInfo{ *best_weight, vertex, best_target,
+                          std::move(edges) };
+    }
+
+    template <typename Weight>
+    template <typename EdgeFilter>
+    std::vector<std::optional<Weight>>
+        DijkstraRouter<Weight>::ComputeWeights(
+            const std::vector<Terminal>& sources,
+            const std::vector<VertexId>& targets,
+            const EdgeFilter& is_open) const {
+
+        const size_t vertex_count = graph_.GetVertexCount();
+        std::vector<std::optional<Weight>> weights(vertex_count);
+        std::vector<bool> is_target(vertex_count, false);
+        size_t targets_left = 0;
+        for (const VertexId target : targets) {
+            if (!is_target.at(target)) {
+                is_target[target] = true;
+                ++targets_left;
+            }
+        }
+
+        std::priority_queue<QueueItem, std::vector<QueueItem>,
+                            std::greater<QueueItem>> queue;
+        for (const auto& source : sources) {
+            auto& weight = weights.at(source.vertex);
+            if (!weight || source.weight < *weight) {
+                weight = source.weight;
+                queue.push({ source.weight, source.vertex });
+            }
+        }
+
+        while (!queue.empty() && targets_left > 0) {
+            const QueueItem item = queue.top();
+            queue.pop();
+            if (*weights[item.vertex] < item.weight) {
+                continue;
+            }
+            if (is_target[item.vertex]) {
+                is_target[item.vertex] = false;
+                --targets_left;
+            }
+            for (const EdgeId edge_id :
+                 graph_.GetIncidentEdges(item.vertex)) {
+                if (!is_open(edge_id)) {
+                    continue;
+                }
+                const auto& edge = graph_.GetEdge(edge_id);
+                if (edge.weight < Weight{}) {
+                    throw std::domain_error(
+                        "Edges' weights should be non-negative");
+                }
+                const Weight candidate = item.weight + edge.weight;
+                auto& weight = weights[edge.to];
+                if (!weight || candidate < *weight) {
+                    weight = candidate;
+                    queue.push({ candidate, edge.to });
+                }
+            }
+        }
+
+        std::vector<std::optional<Weight>> result;
+        result.reserve(targets.size());
+        for (const VertexId target : targets) {
+            result.push_back(weights[target]);
+        }
+        return result;
+    }
+
+} // namespace graph
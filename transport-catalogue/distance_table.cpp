@@ -0,0 +1,154 @@
+#include "distance_table.h"
+
+namespace cat {
+
+    const size_t MIN_CAPACITY = 16;
+
+    void DistanceTable::Reserve(size_t count) {
+        // The load factor is kept at most 1/2.
+        size_t capacity = MIN_CAPACITY;
+        while (capacity < count * 2) {
+            capacity *= 2;
+        }
+        if (capacity > table_.size()) {
+            Rehash(capacity);
+        }
+    }
+
+    void DistanceTable::Set(dom::StopId from, dom::StopId to,
+                            int distance) {
+        Slot& slot = Insert(Key(from, to));
+        if (slot.is_mirrored) {
+            slot.is_mirrored = false;
+            --mirrored_;
+        }
+        slot.distance = distance;
+
+        if (!is_resolved_) {
+            return;
+        }
+        // The reverse direction keeps following this distance until
+        // it is set explicitly.
+        const size_t size = size_;
+        Slot& reverse = Insert(Key(to, from));
+        if (size_ > size) {
+            reverse.is_mirrored = true;
+            ++mirrored_;
+        }
+        if (reverse.is_mirrored) {
+            reverse.distance = distance;
+        }
+    }
+
+    int DistanceTable::Get(dom::StopId from, dom::StopId to) const {
+        if (const Slot* slot = Find(Key(from, to))) {
+            return slot->distance;
+        }
+        if (!is_resolved_) {
+            if (const Slot* slot = Find(Key(to, from))) {
+                return slot->distance;
+            }
+        }
+        return 0;
+    }
+
+    void DistanceTable::ResolveReverse() {
+        std::vector<Slot> explicit_slots;
+        explicit_slots.reserve(size_ - mirrored_);
+        for (const auto& slot : table_) {
+            if (slot.key != EMPTY_KEY && !slot.is_mirrored) {
+                explicit_slots.push_back(slot);
+            }
+        }
+        Reserve(explicit_slots.size() * 2);
+
+        for (const auto& slot : explicit_slots) {
+            const uint64_t reverse_key = (slot.key << 32) | (slot.key >> 32);
+            if (Find(reverse_key) == nullptr) {
+                Slot& reverse = Insert(reverse_key);
+                reverse.distance = slot.distance;
+                reverse.is_mirrored = true;
+                ++mirrored_;
+            }
+        }
+        is_resolved_ = true;
+    }
+
+    size_t DistanceTable::GetSize() const {
+        return size_ - mirrored_;
+    }
+
+    void DistanceTable::Clear() {
+        slots_.clear();
+        table_ = { nullptr, nullptr };
+        size_ = 0;
+        mirrored_ = 0;
+        is_resolved_ = false;
+    }
+
+    // private:
+
+    uint64_t DistanceTable::Key(dom::StopId from, dom::StopId to) {
+        return (static_cast<uint64_t>(from) << 32) | to;
+    }
+
+    // The finalizer of splitmix64.
+    uint64_t DistanceTable::Mix(uint64_t key) {
+        key = (key ^ (key >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        key = (key ^ (key >> 27)) * 0x94d049bb133111ebULL;
+        return key ^ (key >> 31);
+    }
+
+    const DistanceTable::Slot* DistanceTable::Find(uint64_t key) const {
+        if (table_.empty()) {
+            return nullptr;
+        }
+        const size_t mask = table_.size() - 1;
+        for (size_t i = Mix(key) & mask; ; i = (i + 1) & mask) {
+            if (table_[i].key == key) {
+                return &table_[i];
+            }
+            if (table_[i].key == EMPTY_KEY) {
+                return nullptr;
+            }
+        }
+    }
+
+    DistanceTable::Slot& DistanceTable::Insert(uint64_t key) {
+        if ((size_ + 1) * 2 > table_.size()) {
+            Rehash(table_.empty() ? MIN_CAPACITY : table_.size() * 2);
+        }
+        else if (slots_.empty()) {
+            // The slots are viewed in a mapped base.
+            Rehash(table_.size());
+        }
+        const size_t mask = slots_.size() - 1;
+        size_t i = Mix(key) & mask;
+        while (slots_[i].key != key && slots_[i].key != EMPTY_KEY) {
+            i = (i + 1) & mask;
+        }
+        if (slots_[i].key == EMPTY_KEY) {
+            slots_[i].key = key;
+            ++size_;
+        }
+        return slots_[i];
+    }
+
+    void DistanceTable::Rehash(size_t capacity) {
+        std::vector<Slot> slots(capacity);
+        const size_t mask = capacity - 1;
+        for (const auto& slot : table_) {
+            if (slot.key == EMPTY_KEY) {
+                continue;
+            }
+            size_t i = Mix(slot.key) & mask;
+            while (slots[i].key != EMPTY_KEY) {
+                i = (i + 1) & mask;
+            }
+            slots[i] = slot;
+        }
+        slots_ = std::move(slots);
+        table_ = { slots_.data(), slots_.data() + slots_.size() };
+    }
+
+} // namespace cat
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "domain.h"
+#include "ranges.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace serialization {
+    class FlatBase;
+} // namespace serialization
+
+namespace cat {
+
+    // Road distances between stops in one flat open-addressing table
+    // keyed by the packed pair of stop ids. Once the base is loaded,
+    // ResolveReverse() copies every distance given in one direction
+    // only to the other one, so a lookup is a single probe.
+    //
+    // Lookups go through a view of the slots, which is either the
+    // table's own vector or a mapped flat base; the latter is copied
+    // out on the first change.
+    class DistanceTable {
+    public:
+        DistanceTable() = default;
+        DistanceTable(const DistanceTable&) = delete;
+        DistanceTable& operator=(const DistanceTable&) = delete;
+        DistanceTable(DistanceTable&&) = default;
+        DistanceTable& operator=(DistanceTable&&) = default;
+
+        void Reserve(size_t count);
+
+        void Set(dom::StopId from, dom::StopId to, int distance);
+
+        // The distance from `from` to `to`, the reverse one if only
+        // that is known, or 0.
+        int Get(dom::StopId from, dom::StopId to) const;
+
+        void ResolveReverse();
+
+        // Calls action(from, to, distance) for the distances which
+        // were set explicitly.
+        template <typename Action>
+        void ForEach(Action action) const;
+
+        // Number of the distances set explicitly.
+        size_t GetSize() const;
+
+        void Clear();
+
+    private:
+        friend class serialization::FlatBase;
+
+        static constexpr uint64_t EMPTY_KEY = UINT64_MAX;
+
+        struct Slot {
+            uint64_t key = EMPTY_KEY;
+            int distance = 0;
+            bool is_mirrored = false;
+        };
+
+        std::vector<Slot> slots_;
+        // A moved vector keeps its buffer, so the view survives moves.
+        ranges::Range<const Slot*> table_{ nullptr, nullptr };
+        size_t size_ = 0;
+        size_t mirrored_ = 0;
+        bool is_resolved_ = false;
+
+        static uint64_t Key(dom::StopId from, dom::StopId to);
+        static uint64_t Mix(uint64_t key);
+
+        const Slot* Find(uint64_t key) const;
+        Slot& Insert(uint64_t key);
+        void Rehash(size_t capacity);
+    };
+
+    template <typename Action>
+    void DistanceTable::ForEach(Action action) const {
+        for (const auto& slot : table_) {
+            if (slot.key != EMPTY_KEY && !slot.is_mirrored) {
+                action(static_cast<dom::StopId>(slot.key >> 32),
+                       static_cast<dom::StopId>(slot.key),
+                       slot.distance);
+            }
+        }
+    }
+
+} // namespace cat
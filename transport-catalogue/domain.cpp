@@ -1 +1,9 @@
 #include "domain.h"
+
+namespace dom {
+
+    bool IsValid(const Headway& headway) {
+        return headway.interval > 0 && headway.end >= headway.start;
+    }
+
+} // namespace dom
@@ -1,6 +1,12 @@
 #pragma once
 
+#include "geo.h"
+#include "ranges.h"
+
+#include <cstdint>
+#include <optional>
 #include <string>
+#include <string_view>
 #include <variant>
 #include <vector>
 
@@ -8,16 +14,48 @@ namespace dom {
 
     struct Bus;
 
+    // Dense ids: positions of stops and buses in the catalogue.
+    using StopId = uint32_t;
+    using BusId = uint32_t;
+
+    // Names and route stop lists are kept by the catalogue, stops and
+    // buses only refer to them.
     struct Stop {
-        std::string name;
+        std::string_view name;
         double latitude = 0.0;
         double longitude = 0.0;
+        // Of the latitude, kept for distance computations.
+        double sin_lat = 0.0;
+        double cos_lat = 0.0;
+        StopId id = 0;
+    };
+
+    // Departures from the first stop of a bus every `interval`
+    // minutes within [start, end), in minutes after midnight.
+    struct Headway {
+        int start = 0;
+        int end = 0;
+        int interval = 0;
+    };
+
+    // A positive interval and an end not before the start.
+    bool IsValid(const Headway& headway);
+
+    // Route statistics computed once when the base is made.
+    struct BusStats {
+        int route_stops = 0;
+        int unique_stops = 0;
+        int length = 0;
+        double curvature = 0.0;
     };
 
     struct Bus {
-        std::string name;
+        std::string_view name;
         bool is_annular = false;
-        std::vector<Stop*> stops;
+        ranges::Range<const StopId*> stops{ nullptr, nullptr };
+        std::vector<Headway> headways;
+        std::optional<BusStats> stats;
+        BusId id = 0;
     };
 
     struct BusInfo {
@@ -28,19 +66,28 @@ namespace dom {
         double curvature = 0.0;
     };
 
+    // Refers to the catalogue and the request, nothing is copied.
     struct StopInfo {
-        std::string name;
+        std::string_view name;
         bool exists = false;
-        std::vector<Bus*> buses;
+        ranges::Range<const BusId*> buses{ nullptr, nullptr };
+    };
+
+    // A bus going from one stop to another without a transfer,
+    // `span_count` stops on.
+    struct DirectBus {
+        BusId bus = 0;
+        int span_count = 0;
     };
 
     enum class ActionType {
-        WAIT, IN_BUS, IDLE
+        WAIT, IN_BUS, WALK, IDLE
     };
 
     struct TripAction {
         ActionType type = ActionType::IDLE;
         std::string name;
+        std::string to_stop;
         int span_count = 0;
         double time = 0.0;
     };
@@ -50,15 +97,47 @@ namespace dom {
         BUS,
         MAP,
         ROUTE,
+        NEARBY_STOPS,
+        STOP_SEARCH,
+        ROUTE_MATRIX,
+        DIRECT_BUSES,
+        ANALYTICS,
         UNKNOWN
     };
 
+    // A breakpoint of an arrival function: leaving the origin at
+    // any moment up to `departure_time` brings to the destination
+    // at `arrival_time`.
+    struct ProfilePoint {
+        double departure_time = 0.0;
+        double arrival_time = 0.0;
+    };
+
+    // Stops, buses and hops (pairs of consecutive stops of a route, in
+    // this direction) closed in a what-if scenario of a route request.
+    struct Scenario {
+        std::vector<std::string> stops;
+        std::vector<std::string> buses;
+        std::vector<std::pair<std::string, std::string>> hops;
+    };
+
     struct Query {
         QueryType type = QueryType::UNKNOWN;
         int id = 0;
         std::string name;
         std::string from_stop;
         std::string to_stop;
+        std::optional<double> departure_time;
+        std::optional<std::pair<double, double>> departure_window;
+        std::optional<geo::Coordinates> from_point;
+        std::optional<geo::Coordinates> to_point;
+        std::optional<geo::Coordinates> point;
+        double radius = 0.0;
+        std::string prefix;
+        std::optional<size_t> limit;
+        std::vector<std::string> from_stops;
+        std::vector<std::string> to_stops;
+        std::optional<Scenario> scenario;
     };
 
     // Structures for map rendering
@@ -124,10 +203,60 @@ namespace dom {
     struct RoutingSettings {
         int bus_wait_time = 6;
         double bus_velocity = 40.0;
+        double walking_velocity = 5.0;
+        double walking_radius = 1000.0;
+        double transfer_radius = 0.0;
+    };
+
+    // Velocities are set in km/h while times are counted in minutes.
+    const double METERS_PER_MINUTE_PER_KMH = 1000.0 / 60.0;
+
+    // PROTOBUF and COLUMNAR bases can take a log of changes; FLAT
+    // ones are mapped into memory as they are. COLUMNAR is protobuf
+    // with the stops and the distances packed into columns.
+    enum class BaseFormat {
+        PROTOBUF,
+        COLUMNAR,
+        FLAT
     };
 
     struct SerializationSettings {
         std::string filename;
+        BaseFormat format = BaseFormat::PROTOBUF;
+        // Where export_matrix writes the travel times.
+        std::string matrix_filename;
+    };
+
+    // Changes made to a base by apply_delta. A stop or a bus without
+    // `remove` is added, or replaces the one of the same name; a
+    // removed stop leaves the routes and the distances too.
+    struct StopDelta {
+        std::string name;
+        bool remove = false;
+        double latitude = 0.0;
+        double longitude = 0.0;
+    };
+
+    struct DistanceDelta {
+        std::string from_stop;
+        std::string to_stop;
+        int distance = 0;
+        bool remove = false;
+    };
+
+    struct BusDelta {
+        std::string name;
+        bool remove = false;
+        bool is_annular = false;
+        std::vector<std::string> stops;
+        std::vector<Headway> headways;
+    };
+
+    // Applied in the order of stops, distances, buses.
+    struct BaseDelta {
+        std::vector<StopDelta> stops;
+        std::vector<DistanceDelta> distances;
+        std::vector<BusDelta> buses;
     };
 
 } // namespace dom
\ No newline at end of file
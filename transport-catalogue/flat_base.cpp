@@ -0,0 +1,501 @@
+#include "flat_base.h"
+
+#include <array>
+#include <cstring>
+#include <fstream>
+#include <optional>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace serialization {
+
+    using namespace std::literals;
+
+    namespace {
+
+        const char FLAT_MAGIC[4] = { 'T', 'C', 'F', 'B' };
+        const uint32_t FLAT_VERSION = 1;
+        // Reads back as another number in the other byte order.
+        const uint32_t FLAT_BYTE_ORDER = 0x01020304;
+        const size_t FLAT_ALIGNMENT = 64;
+
+        enum Section : uint32_t {
+            STOPS,
+            BUSES,
+            NAMES,
+            HEADWAYS,
+            ROUTE_OFFSETS,
+            ROUTE_STOPS,
+            STOP_BUSES_OFFSETS,
+            STOP_BUSES,
+            DISTANCES,
+            STOP_BUS_BITS,
+            BUSES_BY_NAME,
+            ROUTE_POSITIONS,
+            STOPS_SEARCH,
+            SETTINGS,
+            SECTION_COUNT
+        };
+
+        struct SectionEntry {
+            uint64_t offset = 0;
+            uint64_t size = 0;
+        };
+
+        struct Header {
+            char magic[4] = {};
+            uint32_t version = 0;
+            uint32_t byte_order = 0;
+            uint32_t section_count = 0;
+            uint64_t stop_bus_words = 0;
+            // Filled and mirrored slots of the distance table.
+            uint64_t distances_size = 0;
+            uint64_t distances_mirrored = 0;
+            // Sizes of the records, checked on reading.
+            uint32_t record_sizes[SECTION_COUNT] = {};
+            SectionEntry sections[SECTION_COUNT];
+        };
+
+        // Names are offsets into the NAMES section.
+        struct FlatStop {
+            uint32_t name_offset = 0;
+            uint32_t name_size = 0;
+            double latitude = 0.0;
+            double longitude = 0.0;
+            double sin_lat = 0.0;
+            double cos_lat = 0.0;
+        };
+
+        struct FlatBus {
+            uint32_t name_offset = 0;
+            uint32_t name_size = 0;
+            uint32_t headways_offset = 0;
+            uint32_t headways_count = 0;
+            int32_t route_stops = 0;
+            int32_t unique_stops = 0;
+            int32_t length = 0;
+            uint8_t is_annular = 0;
+            uint8_t has_stats = 0;
+            uint8_t padding[2] = {};
+            double curvature = 0.0;
+        };
+
+        static_assert(std::is_trivially_copyable_v<dom::Headway>);
+
+        // Where a section will go and what it is made of.
+        struct Payload {
+            const void* data = nullptr;
+            size_t count = 0;
+            size_t record_size = 0;
+        };
+
+        template <typename T>
+        Payload MakePayload(const T* data, size_t count) {
+            return { data, count, sizeof(T) };
+        }
+
+        // Records go into the file as they are in memory, padding
+        // included, so they are zeroed before they are filled.
+        template <typename T>
+        void Zero(T& record) {
+            std::memset(static_cast<void*>(&record), 0, sizeof(T));
+        }
+
+        uint64_t Align(uint64_t offset) {
+            return (offset + FLAT_ALIGNMENT - 1) / FLAT_ALIGNMENT
+                * FLAT_ALIGNMENT;
+        }
+
+        template <typename T>
+        std::optional<ranges::Range<const T*>> GetSection(
+            const MappedFile& mapping, const Header& header,
+            Section section) {
+
+            const auto& entry = header.sections[section];
+            if (header.record_sizes[section] != sizeof(T) ||
+                entry.offset % alignof(T) != 0 ||
+                entry.offset > mapping.GetSize() ||
+                entry.size > mapping.GetSize() - entry.offset ||
+                entry.size % sizeof(T) != 0) {
+                return std::nullopt;
+            }
+            const auto* begin = reinterpret_cast<const T*>(
+                mapping.GetData() + entry.offset);
+            return ranges::Range<const T*>(begin,
+                                           begin + entry.size / sizeof(T));
+        }
+
+        template <typename T>
+        bool AllBelow(ranges::Range<const T*> values, size_t bound) {
+            for (const auto value : values) {
+                if (value >= bound) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        // Offsets start with 0, do not decrease and end with `total`.
+        bool AreOffsets(ranges::Range<const uint32_t*> offsets,
+                        size_t count, size_t total) {
+            if (offsets.size() != count + 1 || offsets.front() != 0 ||
+                offsets.back() != total) {
+                return false;
+            }
+            for (size_t i = 1; i < offsets.size(); ++i) {
+                if (offsets[i] < offsets[i - 1]) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+    } // namespace
+
+    bool FlatBase::IsFlat(const std::filesystem::path& file) {
+        std::ifstream in(file, std::ios::binary);
+        char magic[sizeof(FLAT_MAGIC)] = {};
+        return in.read(magic, sizeof(magic)) &&
+            std::memcmp(magic, FLAT_MAGIC, sizeof(magic)) == 0;
+    }
+
+    bool FlatBase::Write(const std::filesystem::path& file,
+                         const cat::TransportCatalogue& db,
+                         const cat_proto::TransportCatalogueBase& settings) {
+
+        std::string names;
+        auto store_name = [&names](std::string_view name) {
+            const auto offset = static_cast<uint32_t>(names.size());
+            names += name;
+            return std::pair{ offset, static_cast<uint32_t>(name.size()) };
+        };
+
+        std::vector<FlatStop> stops;
+        stops.reserve(db.stops_.size());
+        for (const auto& stop : db.stops_) {
+            FlatStop& record = stops.emplace_back();
+            Zero(record);
+            std::tie(record.name_offset, record.name_size) =
+                store_name(stop.name);
+            record.latitude = stop.latitude;
+            record.longitude = stop.longitude;
+            record.sin_lat = stop.sin_lat;
+            record.cos_lat = stop.cos_lat;
+        }
+
+        std::vector<FlatBus> buses;
+        std::vector<dom::Headway> headways;
+        buses.reserve(db.buses_.size());
+        for (const auto& bus : db.buses_) {
+            FlatBus& record = buses.emplace_back();
+            Zero(record);
+            std::tie(record.name_offset, record.name_size) =
+                store_name(bus.name);
+            record.headways_offset = static_cast<uint32_t>(headways.size());
+            record.headways_count = static_cast<uint32_t>(bus.headways.size());
+            headways.insert(headways.end(), bus.headways.begin(),
+                            bus.headways.end());
+            record.is_annular = bus.is_annular;
+            if (bus.stats) {
+                record.has_stats = 1;
+                record.route_stops = bus.stats->route_stops;
+                record.unique_stops = bus.stats->unique_stops;
+                record.length = bus.stats->length;
+                record.curvature = bus.stats->curvature;
+            }
+        }
+
+        // The search names follow the other ones, so the offsets of
+        // the entries are moved by where they start.
+        const auto& views = db.views_;
+        const auto search_names_offset = static_cast<uint32_t>(names.size());
+        names.append(views.search_names.begin(), views.search_names.end());
+        std::vector<cat::TransportCatalogue::SearchEntry> search(views.stops_search.begin(),
+                                        views.stops_search.end());
+        for (auto& entry : search) {
+            entry.name_offset += search_names_offset;
+        }
+
+        const std::string settings_data = settings.SerializeAsString();
+        using Slot = cat::DistanceTable::Slot;
+        const auto& table = db.distances_.table_;
+        std::vector<Slot> slots(table.size());
+        for (size_t i = 0; i < table.size(); ++i) {
+            Zero(slots[i]);
+            slots[i].key = table[i].key;
+            slots[i].distance = table[i].distance;
+            slots[i].is_mirrored = table[i].is_mirrored;
+        }
+
+        std::array<Payload, SECTION_COUNT> payloads;
+        payloads[STOPS] = MakePayload(stops.data(), stops.size());
+        payloads[BUSES] = MakePayload(buses.data(), buses.size());
+        payloads[NAMES] = MakePayload(names.data(), names.size());
+        payloads[HEADWAYS] = MakePayload(headways.data(), headways.size());
+        payloads[ROUTE_OFFSETS] = MakePayload(views.route_offsets.begin(),
+                                              views.route_offsets.size());
+        payloads[ROUTE_STOPS] = MakePayload(views.route_stops.begin(),
+                                            views.route_stops.size());
+        payloads[STOP_BUSES_OFFSETS] = MakePayload(
+            views.stop_buses_offsets.begin(),
+            views.stop_buses_offsets.size());
+        payloads[STOP_BUSES] = MakePayload(views.stop_buses.begin(),
+                                           views.stop_buses.size());
+        payloads[DISTANCES] = MakePayload(slots.data(), slots.size());
+        payloads[STOP_BUS_BITS] = MakePayload(views.stop_bus_bits.begin(),
+                                              views.stop_bus_bits.size());
+        payloads[BUSES_BY_NAME] = MakePayload(views.buses_by_name.begin(),
+                                              views.buses_by_name.size());
+        payloads[ROUTE_POSITIONS] = MakePayload(
+            views.route_positions.begin(), views.route_positions.size());
+        payloads[STOPS_SEARCH] = MakePayload(search.data(), search.size());
+        payloads[SETTINGS] = MakePayload(settings_data.data(),
+                                         settings_data.size());
+
+        Header header;
+        Zero(header);
+        std::memcpy(header.magic, FLAT_MAGIC, sizeof(FLAT_MAGIC));
+        header.version = FLAT_VERSION;
+        header.byte_order = FLAT_BYTE_ORDER;
+        header.section_count = SECTION_COUNT;
+        header.stop_bus_words = db.stop_bus_words_;
+        header.distances_size = db.distances_.size_;
+        header.distances_mirrored = db.distances_.mirrored_;
+        uint64_t offset = sizeof(Header);
+        for (uint32_t i = 0; i < SECTION_COUNT; ++i) {
+            offset = Align(offset);
+            header.record_sizes[i] =
+                static_cast<uint32_t>(payloads[i].record_size);
+            header.sections[i] = { offset,
+                payloads[i].count * payloads[i].record_size };
+            offset += header.sections[i].size;
+        }
+
+        std::filesystem::path temp_file = file;
+        temp_file += ".tmp"s;
+        std::error_code error;
+        {
+            std::ofstream out(temp_file, std::ios::binary);
+            out.write(reinterpret_cast<const char*>(&header),
+                      sizeof(header));
+            uint64_t position = sizeof(header);
+            const std::array<char, FLAT_ALIGNMENT> padding = {};
+            for (uint32_t i = 0; i < SECTION_COUNT; ++i) {
+                out.write(padding.data(),
+                          header.sections[i].offset - position);
+                out.write(static_cast<const char*>(payloads[i].data),
+                          header.sections[i].size);
+                position = header.sections[i].offset +
+                    header.sections[i].size;
+            }
+            out.close();
+            if (!out) {
+                std::filesystem::remove(temp_file, error);
+                return false;
+            }
+        }
+        std::filesystem::rename(temp_file, file, error);
+        if (error) {
+            std::filesystem::remove(temp_file, error);
+            return false;
+        }
+        return true;
+    }
+
+    bool FlatBase::Read(const std::filesystem::path& file,
+                        cat::TransportCatalogue& db,
+                        cat_proto::TransportCatalogueBase& settings) {
+
+        const auto mapping = MappedFile::Open(file);
+        if (!mapping || mapping->GetSize() < sizeof(Header)) {
+            return false;
+        }
+        Header header;
+        std::memcpy(&header, mapping->GetData(), sizeof(header));
+        if (std::memcmp(header.magic, FLAT_MAGIC, sizeof(FLAT_MAGIC)) != 0 ||
+            header.version != FLAT_VERSION ||
+            header.byte_order != FLAT_BYTE_ORDER ||
+            header.section_count != SECTION_COUNT) {
+            return false;
+        }
+
+        using Slot = cat::DistanceTable::Slot;
+        const auto stops = GetSection<FlatStop>(*mapping, header, STOPS);
+        const auto buses = GetSection<FlatBus>(*mapping, header, BUSES);
+        const auto names = GetSection<char>(*mapping, header, NAMES);
+        const auto headways =
+            GetSection<dom::Headway>(*mapping, header, HEADWAYS);
+        const auto route_offsets =
+            GetSection<uint32_t>(*mapping, header, ROUTE_OFFSETS);
+        const auto route_stops =
+            GetSection<dom::StopId>(*mapping, header, ROUTE_STOPS);
+        const auto stop_buses_offsets =
+            GetSection<uint32_t>(*mapping, header, STOP_BUSES_OFFSETS);
+        const auto stop_buses =
+            GetSection<dom::BusId>(*mapping, header, STOP_BUSES);
+        const auto distances = GetSection<Slot>(*mapping, header, DISTANCES);
+        const auto stop_bus_bits =
+            GetSection<uint64_t>(*mapping, header, STOP_BUS_BITS);
+        const auto buses_by_name =
+            GetSection<dom::BusId>(*mapping, header, BUSES_BY_NAME);
+        using RoutePosition = cat::TransportCatalogue::RoutePosition;
+        using SearchEntry = cat::TransportCatalogue::SearchEntry;
+        const auto positions =
+            GetSection<RoutePosition>(*mapping, header, ROUTE_POSITIONS);
+        const auto search =
+            GetSection<SearchEntry>(*mapping, header, STOPS_SEARCH);
+        const auto settings_data =
+            GetSection<char>(*mapping, header, SETTINGS);
+        if (!stops || !buses || !names || !headways || !route_offsets ||
+            !route_stops || !stop_buses_offsets || !stop_buses ||
+            !distances || !stop_bus_bits || !buses_by_name ||
+            !positions || !search || !settings_data) {
+            return false;
+        }
+
+        // Everything the queries index by is checked, so that a
+        // damaged base is refused rather than read out of bounds.
+        const size_t stops_count = stops->size();
+        const size_t buses_count = buses->size();
+        const size_t slots_count = distances->size();
+        auto is_name = [&names](uint32_t offset, uint32_t size) {
+            return offset <= names->size() && size <= names->size() - offset;
+        };
+        if (!AreOffsets(*route_offsets, buses_count, route_stops->size()) ||
+            !AllBelow(*route_stops, stops_count) ||
+            !AreOffsets(*stop_buses_offsets, stops_count,
+                        stop_buses->size()) ||
+            !AllBelow(*stop_buses, buses_count) ||
+            !AllBelow(*buses_by_name, buses_count) ||
+            buses_by_name->size() != buses_count ||
+            header.stop_bus_words != (buses_count + 63) / 64 ||
+            stop_bus_bits->size() != stops_count * header.stop_bus_words ||
+            positions->size() != route_stops->size() ||
+            search->size() != stops_count ||
+            (slots_count & (slots_count - 1)) != 0 ||
+            header.distances_size * 2 > slots_count ||
+            header.distances_mirrored > header.distances_size) {
+            return false;
+        }
+        for (const auto& stop : *stops) {
+            if (!is_name(stop.name_offset, stop.name_size)) {
+                return false;
+            }
+        }
+        for (const auto& bus : *buses) {
+            if (!is_name(bus.name_offset, bus.name_size) ||
+                bus.headways_offset > headways->size() ||
+                bus.headways_count >
+                    headways->size() - bus.headways_offset) {
+                return false;
+            }
+        }
+        for (const auto& headway : *headways) {
+            if (!dom::IsValid(headway)) {
+                return false;
+            }
+        }
+        // Lookups probe up to an empty slot. The header keeps at most
+        // half of the slots filled, so the table is checked to hold
+        // what the header says.
+        size_t filled_slots = 0;
+        size_t mirrored_slots = 0;
+        for (const auto& slot : *distances) {
+            if (slot.key == cat::DistanceTable::EMPTY_KEY) {
+                continue;
+            }
+            if ((slot.key >> 32) >= stops_count ||
+                (slot.key & 0xffffffffu) >= stops_count) {
+                return false;
+            }
+            ++filled_slots;
+            mirrored_slots += slot.is_mirrored ? 1 : 0;
+        }
+        if (filled_slots != header.distances_size ||
+            mirrored_slots != header.distances_mirrored) {
+            return false;
+        }
+        for (const auto& entry : *search) {
+            if (!is_name(entry.name_offset, entry.name_size) ||
+                entry.stop >= stops_count) {
+                return false;
+            }
+        }
+        for (const auto& position : *positions) {
+            if (position.stop >= stops_count) {
+                return false;
+            }
+        }
+        if (!settings.ParseFromArray(settings_data->begin(),
+                static_cast<int>(settings_data->size()))) {
+            return false;
+        }
+
+        auto name_at = [&names](uint32_t offset, uint32_t size) {
+            return std::string_view(names->begin() + offset, size);
+        };
+
+        db.Clear();
+        db.stops_.resize(stops_count);
+        db.stops_map_.reserve(stops_count);
+        for (size_t i = 0; i < stops_count; ++i) {
+            const FlatStop& record = (*stops)[i];
+            dom::Stop& stop = db.stops_[i];
+            stop.name = name_at(record.name_offset, record.name_size);
+            stop.latitude = record.latitude;
+            stop.longitude = record.longitude;
+            stop.sin_lat = record.sin_lat;
+            stop.cos_lat = record.cos_lat;
+            stop.id = static_cast<dom::StopId>(i);
+            db.stops_map_[stop.name] = stop.id;
+        }
+
+        db.buses_.resize(buses_count);
+        db.buses_map_.reserve(buses_count);
+        for (size_t i = 0; i < buses_count; ++i) {
+            const FlatBus& record = (*buses)[i];
+            dom::Bus& bus = db.buses_[i];
+            bus.name = name_at(record.name_offset, record.name_size);
+            bus.is_annular = record.is_annular != 0;
+            const auto* headways_begin =
+                headways->begin() + record.headways_offset;
+            bus.headways.assign(headways_begin,
+                                headways_begin + record.headways_count);
+            if (record.has_stats != 0) {
+                bus.stats = dom::BusStats{ record.route_stops,
+                    record.unique_stops, record.length, record.curvature };
+            }
+            bus.id = static_cast<dom::BusId>(i);
+            db.buses_map_[bus.name] = bus.id;
+        }
+
+        // The arrays stay in the mapping.
+        auto& views = db.views_;
+        views.route_stops = *route_stops;
+        views.route_offsets = *route_offsets;
+        for (auto& bus : db.buses_) {
+            bus.stops = { route_stops->begin() + (*route_offsets)[bus.id],
+                          route_stops->begin() + (*route_offsets)[bus.id + 1] };
+        }
+        views.stop_buses_offsets = *stop_buses_offsets;
+        views.stop_buses = *stop_buses;
+
+        db.distances_.table_ = *distances;
+        db.distances_.size_ = header.distances_size;
+        db.distances_.mirrored_ = header.distances_mirrored;
+        db.distances_.is_resolved_ = true;
+
+        db.stop_bus_words_ = header.stop_bus_words;
+        views.stop_bus_bits = *stop_bus_bits;
+        views.buses_by_name = *buses_by_name;
+        views.route_positions = *positions;
+        views.stops_search = *search;
+        views.search_names = *names;
+
+        db.BuildStopsIndex();
+        db.storage_ = mapping;
+        return true;
+    }
+
+} // namespace serialization
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <transport_catalogue.pb.h>
+
+#include "mapped_file.h"
+#include "transport_catalogue.h"
+
+#include <cstdint>
+#include <filesystem>
+
+namespace serialization {
+
+    // Base laid out the way the catalogue keeps it in memory: a
+    // header with a table of sections, each an aligned array of
+    // fixed-size records. Reading maps the file and the catalogue
+    // queries the arrays and the names in the mapping, with no
+    // parsing, copying or Finalize. Only the stop and bus records,
+    // the name maps and the spatial index are built anew.
+    //
+    // The records follow the native byte order and type sizes, which
+    // the header records, so a base is read where it was made.
+    class FlatBase {
+    public:
+        static bool IsFlat(const std::filesystem::path& file);
+
+        // The settings go as one protobuf message section. The file is
+        // written next to `file` and renamed over it, so processes
+        // which have the old base mapped keep reading it. Returns false,
+        // leaving `file` as it was, if the file can not be written.
+        static bool Write(const std::filesystem::path& file,
+                          const cat::TransportCatalogue& db,
+                          const cat_proto::TransportCatalogueBase& settings);
+
+        // Returns false if the file is not a flat base made here or
+        // is damaged.
+        static bool Read(const std::filesystem::path& file,
+                         cat::TransportCatalogue& db,
+                         cat_proto::TransportCatalogueBase& settings);
+    };
+
+} // namespace serialization
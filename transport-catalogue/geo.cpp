@@ -2,12 +2,14 @@
 
 #include "geo.h"
 
+#include <algorithm>
 #include <cmath>
 
 namespace geo {
 
     const double RADIAN_PER_DEGREE = 0.017453292519;  // PI / 180
     const double THE_RADIUS_OF_EARTH = 6371000.0;
+    const size_t LENGTH_BLOCK_SIZE = 64;
 
     double ComputeDistance(Coordinates from, Coordinates to) {
         if (from == to) {
@@ -21,4 +23,62 @@ namespace geo {
                 RADIAN_PER_DEGREE)) * THE_RADIUS_OF_EARTH;
     }
 
+    PreparedCoordinates Prepare(Coordinates coordinates) {
+        return { coordinates,
+                 std::sin(coordinates.lat * RADIAN_PER_DEGREE),
+                 std::cos(coordinates.lat * RADIAN_PER_DEGREE) };
+    }
+
+    double ComputeDistance(const PreparedCoordinates& from,
+                           const PreparedCoordinates& to) {
+        if (from.coordinates == to.coordinates) {
+            return 0;
+        }
+        return std::acos(from.sin_lat * to.sin_lat +
+            from.cos_lat * to.cos_lat *
+            std::cos(std::abs(from.coordinates.lng - to.coordinates.lng) *
+                RADIAN_PER_DEGREE)) * THE_RADIUS_OF_EARTH;
+    }
+
+    double ComputeLength(const double* lat, const double* lng,
+                         const double* sin_lat, const double* cos_lat,
+                         size_t count) {
+        double result = 0.0;
+        if (count < 2) {
+            return result;
+        }
+
+        // Segments go in blocks: the arithmetic passes have no calls
+        // and vectorize, only cos and acos stay per segment.
+        double cosines[LENGTH_BLOCK_SIZE];
+        for (size_t begin = 0; begin + 1 < count;
+             begin += LENGTH_BLOCK_SIZE) {
+            const size_t size =
+                std::min(LENGTH_BLOCK_SIZE, count - 1 - begin);
+            const double* lat_from = lat + begin;
+            const double* lng_from = lng + begin;
+            const double* sin_from = sin_lat + begin;
+            const double* cos_from = cos_lat + begin;
+
+            for (size_t i = 0; i < size; ++i) {
+                cosines[i] = std::abs(lng_from[i] - lng_from[i + 1]) *
+                    RADIAN_PER_DEGREE;
+            }
+            for (size_t i = 0; i < size; ++i) {
+                cosines[i] = std::cos(cosines[i]);
+            }
+            for (size_t i = 0; i < size; ++i) {
+                cosines[i] = sin_from[i] * sin_from[i + 1] +
+                    cos_from[i] * cos_from[i + 1] * cosines[i];
+            }
+            for (size_t i = 0; i < size; ++i) {
+                if (lat_from[i] != lat_from[i + 1] ||
+                    lng_from[i] != lng_from[i + 1]) {
+                    result += std::acos(cosines[i]) * THE_RADIUS_OF_EARTH;
+                }
+            }
+        }
+        return result;
+    }
+
 }  // namespace geo
\ No newline at end of file
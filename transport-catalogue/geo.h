@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstddef>
+
 namespace geo {
 
     struct Coordinates {
@@ -15,4 +17,26 @@ namespace geo {
 
     double ComputeDistance(Coordinates from, Coordinates to);
 
+    // A point with the sine and cosine of its latitude computed once,
+    // for measuring many distances from it.
+    struct PreparedCoordinates {
+        Coordinates coordinates;
+        double sin_lat = 0.0;
+        double cos_lat = 0.0;
+    };
+
+    PreparedCoordinates Prepare(Coordinates coordinates);
+
+    // The same value as ComputeDistance of the unprepared points.
+    double ComputeDistance(const PreparedCoordinates& from,
+                           const PreparedCoordinates& to);
+
+    // Length of the polyline through `count` points given as separate
+    // arrays of latitudes, longitudes and the sines and cosines of the
+    // latitudes. Equals the sum of ComputeDistance over consecutive
+    // points, added up in order.
+    double ComputeLength(const double* lat, const double* lng,
+                         const double* sin_lat, const double* cos_lat,
+                         size_t count);
+
 }  // namespace geo
\ No newline at end of file
@@ -9,8 +9,7 @@ namespace txt {
     std::vector<dom::Query>
     QueriesToDataBase(cat::TransportCatalogue& db,
                       std::istream& in) {
-        Distances distances;
-        Routes buses;
+        cat::CatalogueBuilder builder;
         std::vector<dom::Query> queries;
         std::string line;
         int count = 0;
@@ -45,14 +44,14 @@ namespace txt {
 
                 auto key = tokens[0].substr(0, pos);
                 auto name = Trim(tokens[0].substr(pos));
-                // "Stop" has top priority to add.
                 if (key == "Stop"sv) {
-                    LoadStops(name, tokens[1], db, distances);
+                    LoadStops(name, tokens[1], builder);
                     continue;
                 }
-                // "Bus" must be added after all "Stop" additions.
+                // Stops of the bus are checked when all the base
+                // is read.
                 if (key == "Bus"sv) {
-                    LoadRoutes(name, tokens[1], buses);
+                    LoadRoutes(name, tokens[1], builder);
                     continue;
                 }
                 continue;
@@ -73,15 +72,7 @@ namespace txt {
             queries.push_back(std::move(query));
         }
 
-        // Add Distances to database
-        for (auto& [key, stops] : distances) {
-            db.AddStopDistances(key, std::move(stops));
-        }
-
-        // Add "Bus" to database
-        for (auto& [key, stops] : buses) {
-            db.AddBus(key, stops.first, std::move(stops.second));
-        }
+        db = builder.Freeze();
 
         return queries;
     }
@@ -101,32 +92,25 @@ namespace txt {
 
     void LoadStops(std::string_view name,
         std::string_view query,
-        cat::TransportCatalogue& db,
-        Distances& distances) {
+        cat::CatalogueBuilder& builder) {
         auto values = Split(query, ',');
         auto value_size = values.size();
         if (value_size < 2) {
             return;
         }
-        // Add to data base
-        db.AddStop(name, std::atof(std::string(values[0]).data()),
+        builder.AddStop(name, std::atof(std::string(values[0]).data()),
             std::atof(std::string(values[1]).data()));
-        if (value_size < 3) {
-            return;
-        }
-        // Distances must be added after all "Stop" additions.
-        auto& from_stop = distances[std::string(name)];
         for (int i = 2; i < value_size; ++i) {
             auto pos = values[i].find("to"sv);
-            auto stop = std::string(Trim(values[i].substr(pos + 2)));
+            auto stop = Trim(values[i].substr(pos + 2));
             int d = std::atoi(std::string(values[i].substr(0, pos)).data());
-            from_stop.push_back({ stop, d });
+            builder.AddStopDistance(name, stop, d);
         }
     }
 
     void LoadRoutes(std::string_view name,
         std::string_view query,
-        Routes& buses) {
+        cat::CatalogueBuilder& builder) {
         bool round_trip = (query.find('-') != query.npos) ?
             true : false;
         bool annular_trip = (query.find('>') != query.npos) ?
@@ -135,10 +119,10 @@ namespace txt {
             return;
         }
         char delimiter = annular_trip ? '>' : '-';
-        std::vector<std::string> values;
-        Split(query, delimiter, values, true);
-        // Add to buffer
-        buses[std::string(name)] = { annular_trip, std::move(values) };
+        builder.AddBus(name, annular_trip);
+        for (const auto stop : Split(query, delimiter, true)) {
+            builder.AddBusStop(stop);
+        }
     }
 
     bool IsIntNumber(std::string_view value) {
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "catalogue_builder.h"
 #include "transport_catalogue.h"
 
 #include <algorithm>
@@ -12,24 +13,16 @@
 
 namespace txt {
 
-    using Distances =
-        std::unordered_map<std::string,
-        std::vector<std::pair<std::string, int>>>;
-    using Routes =
-        std::unordered_map<std::string,
-        std::pair<bool, std::vector<std::string>>>;
-
     std::vector<dom::Query>
     QueriesToDataBase(cat::TransportCatalogue& db,
                       std::istream& in = std::cin);
     dom::QueryType GetQueryType(std::string_view value);
     void LoadStops(std::string_view name,
             std::string_view query,
-            cat::TransportCatalogue& db,
-            Distances& distances);
+            cat::CatalogueBuilder& builder);
     void LoadRoutes(std::string_view name,
             std::string_view query,
-            Routes& routes);
+            cat::CatalogueBuilder& builder);
 
     bool IsIntNumber(std::string_view symbols);
 
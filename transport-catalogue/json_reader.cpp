@@ -11,11 +11,13 @@ namespace json {
                               cat::TransportRouter& transport_router,
                               serialization::Portal& portal,
                               std::istream& in) {
-        Distances distances;
-        Buses buses;
+        cat::CatalogueBuilder builder;
+        bool has_base = false;
         Document doc = Load(in);
         for (const auto& [key, value] : doc.GetRoot().AsDict()) {
             if (key == "base_requests"sv) {
+                has_base = true;
+                ReserveBase(value.AsArray(), builder);
                 for (const auto& base_request :
                     value.AsArray()) {
                     const Dict& request = base_request.AsDict();
@@ -27,15 +29,14 @@ namespace json {
                     const std::string_view request_type =
                         request.at("type"s).AsString();
                     if (request_type == "Stop"sv) {
-                        // "Stop" has top priority to add.
-                        LoadStops(request, distances, db);
+                        LoadStops(request, builder);
                         continue;
                     }
 
                     if (request_type == "Bus"sv) {
-                        // "Bus" must be added after all
-                        // "Stop" additions.
-                        LoadBuses(request, buses);
+                        // Stops of the bus are checked when all the
+                        // base is read.
+                        LoadBuses(request, builder);
                     }
                 }
                 transport_router.SetRouterIsSet(false);
@@ -58,16 +59,14 @@ namespace json {
                 LoadStatRequests(value.AsArray());
                 continue;
             }
+            if (key == "delta_requests"sv) {
+                LoadDelta(value.AsArray());
+                continue;
+            }
         }
 
-        // Add Distances to database
-        for (auto& [key, stops] : distances) {
-            db.AddStopDistances(key, std::move(stops));
-        }
-
-        // Add "Bus" to database
-        for (auto& [key, stops] : buses) {
-            db.AddBus(key, stops.first, std::move(stops.second));
+        if (has_base) {
+            db = builder.Freeze();
         }
     }
 
@@ -76,51 +75,94 @@ namespace json {
         return stat_requests_;
     }
 
+    const dom::BaseDelta& Reader::GetDelta() const {
+        return delta_;
+    }
+
     // Reader: private
 
+    void Reader::ReserveBase(const Array& base_requests,
+        cat::CatalogueBuilder& builder) {
+        size_t stops_count = 0;
+        size_t distances_count = 0;
+        size_t buses_count = 0;
+        size_t route_stops_count = 0;
+        for (const auto& base_request : base_requests) {
+            const Dict& request = base_request.AsDict();
+            if (request.count("type"s) == 0) {
+                continue;
+            }
+            const std::string_view request_type =
+                request.at("type"s).AsString();
+            if (request_type == "Stop"sv) {
+                ++stops_count;
+                if (request.count("road_distances"s) > 0) {
+                    distances_count +=
+                        request.at("road_distances"s).AsDict().size();
+                }
+            }
+            else if (request_type == "Bus"sv) {
+                ++buses_count;
+                if (request.count("stops"s) > 0) {
+                    route_stops_count +=
+                        request.at("stops"s).AsArray().size();
+                }
+            }
+        }
+        builder.Reserve(stops_count, distances_count, buses_count,
+                        route_stops_count);
+    }
+
     void Reader::LoadStops(const Dict& request,
-        Distances& distances,
-        cat::TransportCatalogue& db) {
+        cat::CatalogueBuilder& builder) {
         if (request.count("name"s) == 0) {
             throw std::runtime_error("Name of stop not found"s);
         }
-        dom::Stop stop;
-        stop.name = request.at("name"s).AsString();
+        const auto& name = request.at("name"s).AsString();
+        double latitude = 0.0;
+        double longitude = 0.0;
         if (request.count("latitude"s) > 0 &&
             request.count("longitude"s) > 0) {
-            stop.latitude = request.at("latitude"s).AsDouble();
-            stop.longitude = request.at("longitude"s).AsDouble();
+            latitude = request.at("latitude"s).AsDouble();
+            longitude = request.at("longitude"s).AsDouble();
         }
+        builder.AddStop(name, latitude, longitude);
 
         if (request.count("road_distances"s) > 0) {
             for (const auto& [to_stop, distance] :
                 request.at("road_distances"s).AsDict()) {
-                distances[stop.name].push_back(
-                    { to_stop, distance.AsInt() });
+                builder.AddStopDistance(name, to_stop,
+                                        distance.AsInt());
             }
         }
-
-        db.AddStop(std::move(stop));
     }
 
-    void Reader::LoadBuses(const Dict& request, Buses& buses) {
+    void Reader::LoadBuses(const Dict& request,
+        cat::CatalogueBuilder& builder) {
         if (request.count("name"s) == 0) {
             throw std::runtime_error("Name of bus not found"s);
         }
-        std::string name = request.at("name"s).AsString();
 
         bool is_roundtrip = false;
         if (request.count("is_roundtrip"s) > 0) {
             is_roundtrip = request.at("is_roundtrip"s).AsBool();
         }
 
-        buses[name].first = is_roundtrip;
+        std::vector<dom::Headway> headways;
+        if (request.count("headways"s) > 0) {
+            for (const auto& item :
+                request.at("headways"s).AsArray()) {
+                headways.push_back(GetHeadway(item));
+            }
+        }
+
+        builder.AddBus(request.at("name"s).AsString(), is_roundtrip,
+                       headways);
 
         if (request.count("stops"s) > 0) {
             for (const auto& stop :
                 request.at("stops"s).AsArray()) {
-                buses.at(name).second.push_back(
-                    stop.AsString());
+                builder.AddBusStop(stop.AsString());
             }
         }
     }
@@ -211,6 +253,18 @@ namespace json {
                 routing_settings.bus_velocity = node.AsDouble();
                 continue;
             }
+            if (key == "walking_velocity"sv) {
+                routing_settings.walking_velocity = node.AsDouble();
+                continue;
+            }
+            if (key == "walking_radius"sv) {
+                routing_settings.walking_radius = node.AsDouble();
+                continue;
+            }
+            if (key == "transfer_radius"sv) {
+                routing_settings.transfer_radius = node.AsDouble();
+                continue;
+            }
         }
     }
 
@@ -224,6 +278,25 @@ namespace json {
                 serialization_settings.filename = node.AsString();
                 continue;
             }
+            if (key == "matrix_file"sv) {
+                serialization_settings.matrix_filename = node.AsString();
+                continue;
+            }
+            if (key == "format"sv) {
+                if (node.AsString() == "protobuf"sv) {
+                    serialization_settings.format = dom::BaseFormat::PROTOBUF;
+                }
+                else if (node.AsString() == "columnar"sv) {
+                    serialization_settings.format = dom::BaseFormat::COLUMNAR;
+                }
+                else if (node.AsString() == "flat"sv) {
+                    serialization_settings.format = dom::BaseFormat::FLAT;
+                }
+                else {
+                    throw std::invalid_argument("Invalid base format"s);
+                }
+                continue;
+            }
         }
     }
 
@@ -263,6 +336,61 @@ namespace json {
         return dom::Color{};
     }
 
+    dom::Headway Reader::GetHeadway(const Node& node) {
+        dom::Headway headway;
+        const Dict& dict = node.AsDict();
+        if (dict.count("start"s) > 0) {
+            headway.start = dict.at("start"s).AsInt();
+        }
+        if (dict.count("end"s) > 0) {
+            headway.end = dict.at("end"s).AsInt();
+        }
+        if (dict.count("interval"s) > 0) {
+            headway.interval = dict.at("interval"s).AsInt();
+        }
+        if (!dom::IsValid(headway)) {
+            throw std::invalid_argument("Invalid Headway in Bus"s);
+        }
+        return headway;
+    }
+
+    geo::Coordinates Reader::GetCoordinates(const Node& node) {
+        const Dict& dict = node.AsDict();
+        if (dict.count("latitude"s) == 0 ||
+            dict.count("longitude"s) == 0) {
+            throw std::invalid_argument("Invalid Point in Route"s);
+        }
+        return { dict.at("latitude"s).AsDouble(),
+                 dict.at("longitude"s).AsDouble() };
+    }
+
+    dom::Scenario Reader::GetScenario(const Node& node) {
+        dom::Scenario scenario;
+        const Dict& dict = node.AsDict();
+        if (dict.count("stops"s) > 0) {
+            for (const auto& stop : dict.at("stops"s).AsArray()) {
+                scenario.stops.push_back(stop.AsString());
+            }
+        }
+        if (dict.count("buses"s) > 0) {
+            for (const auto& bus : dict.at("buses"s).AsArray()) {
+                scenario.buses.push_back(bus.AsString());
+            }
+        }
+        if (dict.count("edges"s) > 0) {
+            for (const auto& item : dict.at("edges"s).AsArray()) {
+                const Dict& hop = item.AsDict();
+                if (hop.count("from"s) == 0 || hop.count("to"s) == 0) {
+                    throw std::invalid_argument(
+                        "Invalid Edge in Scenario"s);
+                }
+                scenario.hops.push_back({ hop.at("from"s).AsString(),
+                                          hop.at("to"s).AsString() });
+            }
+        }
+        return scenario;
+    }
+
     void Reader::LoadStatRequests(const Array& stat_requests) {
         for (const auto& stat_request : stat_requests) {
             const Dict& request = stat_request.AsDict();
@@ -298,6 +426,100 @@ namespace json {
                         request.at("to"s).AsString();
                 }
 
+                if (request.count("from_point"s) > 0) {
+                    query.from_point =
+                        GetCoordinates(request.at("from_point"s));
+                }
+
+                if (request.count("to_point"s) > 0) {
+                    query.to_point =
+                        GetCoordinates(request.at("to_point"s));
+                }
+
+                if (request.count("departure_time"s) > 0) {
+                    query.departure_time =
+                        request.at("departure_time"s).AsDouble();
+                }
+
+                if (request.count("departure_window"s) > 0) {
+                    const Array& window =
+                        request.at("departure_window"s).AsArray();
+                    if (window.size() == 2) {
+                        query.departure_window = {
+                            window[0].AsDouble(),
+                            window[1].AsDouble() };
+                    }
+                }
+
+                if (request.count("scenario"s) > 0) {
+                    query.scenario = GetScenario(request.at("scenario"s));
+                }
+
+            }
+            else if (request_type == "Analytics"sv) {
+                query.type = dom::QueryType::ANALYTICS;
+
+                if (request.count("limit"s) > 0) {
+                    query.limit = static_cast<size_t>(
+                        std::max(0, request.at("limit"s).AsInt()));
+                }
+            }
+            else if (request_type == "DirectBuses"sv) {
+                query.type = dom::QueryType::DIRECT_BUSES;
+
+                if (request.count("from"s) > 0) {
+                    query.from_stop = request.at("from"s).AsString();
+                }
+
+                if (request.count("to"s) > 0) {
+                    query.to_stop = request.at("to"s).AsString();
+                }
+            }
+            else if (request_type == "RouteMatrix"sv) {
+                query.type = dom::QueryType::ROUTE_MATRIX;
+
+                if (request.count("from"s) > 0) {
+                    for (const auto& stop :
+                        request.at("from"s).AsArray()) {
+                        query.from_stops.push_back(stop.AsString());
+                    }
+                }
+
+                if (request.count("to"s) > 0) {
+                    for (const auto& stop :
+                        request.at("to"s).AsArray()) {
+                        query.to_stops.push_back(stop.AsString());
+                    }
+                }
+
+                if (request.count("scenario"s) > 0) {
+                    query.scenario = GetScenario(request.at("scenario"s));
+                }
+            }
+            else if (request_type == "NearbyStops"sv) {
+                query.type = dom::QueryType::NEARBY_STOPS;
+                query.point = GetCoordinates(stat_request);
+
+                if (request.count("radius"s) > 0) {
+                    query.radius = request.at("radius"s).AsDouble();
+                }
+
+                if (request.count("limit"s) > 0) {
+                    query.limit = static_cast<size_t>(
+                        std::max(0, request.at("limit"s).AsInt()));
+                }
+            }
+            else if (request_type == "StopSearch"sv) {
+                query.type = dom::QueryType::STOP_SEARCH;
+
+                if (request.count("prefix"s) > 0) {
+                    query.prefix = request.at("prefix"s).AsString();
+                }
+
+                if (request.count("limit"s) > 0) {
+                    query.limit = static_cast<size_t>(
+                        std::max(0, request.at("limit"s).AsInt()));
+                }
             }
 
             if (request.count("id"s) > 0) {
@@ -312,4 +534,83 @@ namespace json {
         }
     }
 
+    void Reader::LoadDelta(const Array& delta_requests) {
+        for (const auto& delta_request : delta_requests) {
+            const Dict& request = delta_request.AsDict();
+            if (request.count("type"s) == 0) {
+                throw std::runtime_error("Type of data not found"s);
+            }
+
+            const std::string_view request_type =
+                request.at("type"s).AsString();
+            const bool remove = request.count("remove"s) > 0 &&
+                request.at("remove"s).AsBool();
+
+            if (request_type == "Distance"sv) {
+                if (request.count("from"s) == 0 ||
+                    request.count("to"s) == 0) {
+                    throw std::runtime_error(
+                        "Stops of distance not found"s);
+                }
+                dom::DistanceDelta distance;
+                distance.from_stop = request.at("from"s).AsString();
+                distance.to_stop = request.at("to"s).AsString();
+                distance.remove = remove;
+                if (request.count("distance"s) > 0) {
+                    distance.distance = request.at("distance"s).AsInt();
+                }
+                delta_.distances.push_back(std::move(distance));
+                continue;
+            }
+
+            if (request.count("name"s) == 0) {
+                throw std::runtime_error("Name not found"s);
+            }
+            const auto& name = request.at("name"s).AsString();
+
+            if (request_type == "Stop"sv) {
+                dom::StopDelta stop;
+                stop.name = name;
+                stop.remove = remove;
+                if (request.count("latitude"s) > 0 &&
+                    request.count("longitude"s) > 0) {
+                    stop.latitude = request.at("latitude"s).AsDouble();
+                    stop.longitude = request.at("longitude"s).AsDouble();
+                }
+                delta_.stops.push_back(std::move(stop));
+
+                if (!remove && request.count("road_distances"s) > 0) {
+                    for (const auto& [to_stop, distance] :
+                        request.at("road_distances"s).AsDict()) {
+                        delta_.distances.push_back(
+                            { name, to_stop, distance.AsInt(), false });
+                    }
+                }
+                continue;
+            }
+
+            if (request_type == "Bus"sv) {
+                dom::BusDelta bus;
+                bus.name = name;
+                bus.remove = remove;
+                if (request.count("is_roundtrip"s) > 0) {
+                    bus.is_annular = request.at("is_roundtrip"s).AsBool();
+                }
+                if (request.count("stops"s) > 0) {
+                    for (const auto& stop :
+                        request.at("stops"s).AsArray()) {
+                        bus.stops.push_back(stop.AsString());
+                    }
+                }
+                if (request.count("headways"s) > 0) {
+                    for (const auto& item :
+                        request.at("headways"s).AsArray()) {
+                        bus.headways.push_back(GetHeadway(item));
+                    }
+                }
+                delta_.buses.push_back(std::move(bus));
+            }
+        }
+    }
+
 } // namespace json
\ No newline at end of file
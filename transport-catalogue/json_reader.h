@@ -1,5 +1,6 @@
 #pragma once
 
+#include "catalogue_builder.h"
 #include "json.h"
 #include "map_renderer.h"
 #include "serialization.h"
@@ -9,15 +10,6 @@ namespace json {
 
     class Reader {
     public:
-        using Distances =
-            std::unordered_map<std::string /*from_stop*/,
-            std::vector<std::pair<std::string /*to_stop*/,
-            int /*meters*/>>>;
-        using Buses =
-            std::unordered_map<std::string /*bus*/,
-            std::pair<bool /*is_annular*/,
-            std::vector<std::string /*stop*/>>>;
-
         Reader() = default;
 
         void LoadRequests(cat::TransportCatalogue& db,
@@ -27,15 +19,18 @@ namespace json {
                           std::istream& in = std::cin);
 
         const std::vector<dom::Query>& GetStatRequests() const;
+        const dom::BaseDelta& GetDelta() const;
 
     private:
         std::vector<dom::Query> stat_requests_;
+        dom::BaseDelta delta_;
 
+        void ReserveBase(const Array& base_requests,
+            cat::CatalogueBuilder& builder);
         void LoadStops(const Dict& request,
-            Distances& distances,
-            cat::TransportCatalogue& db);
+            cat::CatalogueBuilder& builder);
         void LoadBuses(const Dict& request,
-            Buses& buses);
+            cat::CatalogueBuilder& builder);
 
         void LoadRouteMapSettings(svg::MapRenderer& map_renderer,
                                   const Dict& requests);
@@ -46,8 +41,12 @@ namespace json {
 
         dom::Point GetLabelOffset(const Node& node);
         dom::Color GetColor(const Node& node);
+        dom::Headway GetHeadway(const Node& node);
+        geo::Coordinates GetCoordinates(const Node& node);
+        dom::Scenario GetScenario(const Node& node);
 
         void LoadStatRequests(const Array& stat_requests);
+        void LoadDelta(const Array& delta_requests);
     };
 
 } // namespace json
\ No newline at end of file
@@ -1,5 +1,6 @@
 #include "request_handler.h"
 #include "serialization.h"
+#include "snapshot.h"
 
 #include <fstream>
 #include <iostream>
@@ -7,7 +8,9 @@
 using namespace std::literals;
 
 void PrintUsage(std::ostream& stream = std::cerr) {
-    stream << "Usage: transport_catalogue [make_base|process_requests]\n"sv;
+    stream << "Usage: transport_catalogue "sv
+           << "[make_base|process_requests|serve_requests|apply_delta|"sv
+           << "export_matrix]\n"sv;
 }
 
 int main(int argc, char* argv[]) {
@@ -34,16 +37,122 @@ int main(int argc, char* argv[]) {
 
     if (mode == "make_base"sv) {
         std::string file_name = portal.GetSerializationSettings().filename;
-        srlz::Path file_path = std::filesystem::path(file_name);
-        portal.Serialize(file_path, db, map_renderer, transport_router);
+        serialization::Path file_path = std::filesystem::path(file_name);
+        transport_router.BuildComponents(db);
+        if (!portal.Serialize(file_path, db, map_renderer,
+                              transport_router)) {
+            std::cerr << "Can not write base "sv << file_name << "\n"sv;
+            return 1;
+        }
     }
     else if (mode == "process_requests"sv) {
         std::string file_name = portal.GetSerializationSettings().filename;
-        srlz::Path file_path = std::filesystem::path(file_name);
+        serialization::Path file_path = std::filesystem::path(file_name);
         db.Clear();
-        portal.Deserialize(file_path, db, map_renderer, transport_router);
+        if (!portal.Deserialize(file_path, db, map_renderer,
+                                transport_router)) {
+            std::cerr << "Can not read base "sv << file_name << "\n"sv;
+            return 1;
+        }
+        if (request_handler.NeedsRouter()) {
+            transport_router.BuildGraph(db);
+            transport_router.SetRouterIsSet(true);
+        }
         request_handler.JSONout(std::cout);
     }
+    else if (mode == "apply_delta"sv) {
+        // Appends the changes of delta_requests to the log of the base.
+        // Once the log grows big, the base is rewritten with it folded
+        // in, next to the old one and then renamed over it.
+        std::string file_name = portal.GetSerializationSettings().filename;
+        serialization::Path file_path = std::filesystem::path(file_name);
+        if (serialization::FlatBase::IsFlat(file_path)) {
+            std::cerr << "Base "sv << file_name
+                      << " is flat and takes no changes\n"sv;
+            return 1;
+        }
+        if (!portal.AppendDelta(file_path, read_from_json.GetDelta())) {
+            std::cerr << "Can not write base "sv << file_name << "\n"sv;
+            return 1;
+        }
+        if (portal.IsLogOversized(file_path)) {
+            db.Clear();
+            if (!portal.Deserialize(file_path, db, map_renderer,
+                                    transport_router)) {
+                std::cerr << "Can not read base "sv << file_name << "\n"sv;
+                return 1;
+            }
+            transport_router.BuildComponents(db);
+            if (!portal.Serialize(file_path, db, map_renderer,
+                                  transport_router)) {
+                std::cerr << "Can not write base "sv << file_name
+                          << "\n"sv;
+                return 1;
+            }
+        }
+    }
+    else if (mode == "export_matrix"sv) {
+        // Writes the travel times between all the stops of the base to
+        // matrix_file; the routing tables are not built for it.
+        std::string file_name = portal.GetSerializationSettings().filename;
+        serialization::Path file_path = std::filesystem::path(file_name);
+        db.Clear();
+        if (!portal.Deserialize(file_path, db, map_renderer,
+                                transport_router)) {
+            std::cerr << "Can not read base "sv << file_name << "\n"sv;
+            return 1;
+        }
+        transport_router.BuildEdges(db);
+
+        const auto& matrix_name =
+            portal.GetSerializationSettings().matrix_filename;
+        std::ofstream out(matrix_name, std::ios::binary);
+        if (!out) {
+            std::cerr << "Can not write matrix "sv << matrix_name << "\n"sv;
+            return 1;
+        }
+        transport_router.WriteTravelTimes(out);
+        out.close();
+        if (!out) {
+            std::cerr << "Can not write matrix "sv << matrix_name << "\n"sv;
+            return 1;
+        }
+    }
+    else if (mode == "serve_requests"sv) {
+        // Answers every next JSON document of stat requests with the
+        // base as it is at the moment, reloading it when the file
+        // changes.
+        std::string file_name = portal.GetSerializationSettings().filename;
+        serialization::BaseWatcher watcher(portal,
+            std::filesystem::path(file_name));
+        if (!watcher.Start()) {
+            std::cerr << "Can not read base "sv << file_name << "\n"sv;
+            return 1;
+        }
+
+        json::Reader reader = read_from_json;
+        cat::TransportCatalogue requests_db;
+        svg::MapRenderer requests_map_renderer;
+        cat::TransportRouter requests_router;
+        serialization::Portal requests_portal;
+        while (true) {
+            const auto snapshot = watcher.GetSnapshot();
+            RequestHandler handler{ reader,
+                                    snapshot->db,
+                                    snapshot->map_renderer,
+                                    snapshot->transport_router };
+            handler.JSONout(std::cout);
+            std::cout << std::endl;
+
+            if ((std::cin >> std::ws).eof()) {
+                break;
+            }
+            reader = json::Reader();
+            reader.LoadRequests(requests_db, requests_map_renderer,
+                                requests_router, requests_portal,
+                                std::cin);
+        }
+    }
     else {
         PrintUsage();
         return 1;
@@ -24,7 +24,7 @@ namespace svg {
     using namespace std::literals;
 
     const svg::Document MapRenderer::RenderMap(
-        const cat::TransportCatalogue& db) {
+        const cat::TransportCatalogue& db) const {
 
         std::set<std::string_view> sortered_bus_names;
         std::map<std::string_view, dom::Point>
@@ -35,16 +35,14 @@ namespace svg {
         int color_index = 0;
 
         std::vector<std::unique_ptr<svg::Drawable>> text_container;
-        const auto& buses = db.GetBuses();
-
         svg::Document doc;
         for (const auto& bus_name : sortered_bus_names) {
 
-            const auto& bus = buses.at(bus_name);
+            const auto& bus = *db.GetBus(bus_name);
 
             color_index = color_index >= colors_count ? 0 : color_index;
 
-            svg::Polyline polyline = CreateRoute(bus,
+            svg::Polyline polyline = CreateRoute(db, bus,
                 stop_coords,
                 svg::NoneColor,
                 route_map_settings_.color_palette[color_index],
@@ -56,7 +54,7 @@ namespace svg {
 
             auto base_text =
                 BaseText(bus_name,
-                    stop_coords.at(bus->stops.front()->name),
+                    stop_coords.at(db.GetStop(bus.stops.front()).name),
                     route_map_settings_.bus_label_offset,
                     route_map_settings_.bus_label_font_size,
                     "Verdana"s, "bold"s);
@@ -71,11 +69,11 @@ namespace svg {
             text_container.push_back(
                 std::make_unique<svg::Label>(caption));
 
-            if (!bus->is_annular
-                && bus->stops.front() != bus->stops.back()) {
+            if (!bus.is_annular
+                && bus.stops.front() != bus.stops.back()) {
                 base_text =
                     BaseText(bus_name,
-                        stop_coords.at(bus->stops.back()->name),
+                        stop_coords.at(db.GetStop(bus.stops.back()).name),
                         route_map_settings_.bus_label_offset,
                         route_map_settings_.bus_label_font_size,
                         "Verdana"s, "bold"s);
@@ -131,19 +129,20 @@ namespace svg {
 
     std::map<std::string_view, dom::Point>
     MapRenderer::StopCoords(const cat::TransportCatalogue& db,
-                            std::set<std::string_view>& buses) {
+                            std::set<std::string_view>& buses) const {
 
         std::map<std::string_view, dom::Point> coords;
 
         std::vector<geo::Coordinates> geo_coords;
-        std::unordered_set<dom::Stop*> stops;
+        std::unordered_set<const dom::Stop*> stops;
 
-        for (const auto& [bus_name, bus] : db.GetBuses()) {
-            for (const auto& stop : bus->stops) {
+        for (const auto& [bus_name, bus_id] : db.GetBuses()) {
+            for (const auto stop_id : db.GetBus(bus_id).stops) {
+                const auto& stop = db.GetStop(stop_id);
                 buses.insert(bus_name);
-                stops.insert(stop);
-                geo_coords.push_back({ stop->latitude,
-                                       stop->longitude });
+                stops.insert(&stop);
+                geo_coords.push_back({ stop.latitude,
+                                       stop.longitude });
             }
         }
 
@@ -162,24 +161,26 @@ namespace svg {
         return coords;
     }
 
-    svg::Polyline MapRenderer::CreateRoute(const dom::Bus* bus,
+    svg::Polyline MapRenderer::CreateRoute(
+        const cat::TransportCatalogue& db,
+        const dom::Bus& bus,
         const std::map<std::string_view, dom::Point>& stop_coords,
         const dom::Color& fill_color,
         const dom::Color& stroke_color,
         const double stroke_width,
         const svg::StrokeLineCap stroke_line_cap,
-        const svg::StrokeLineJoin stroke_line_join) {
+        const svg::StrokeLineJoin stroke_line_join) const {
 
         svg::Polyline polyline;
 
-        for (const auto& stop : bus->stops) {
-            polyline.AddPoint(stop_coords.at(stop->name));
+        for (const auto stop : bus.stops) {
+            polyline.AddPoint(stop_coords.at(db.GetStop(stop).name));
         }
 
-        if (!bus->is_annular) {
-            for (auto it = bus->stops.rbegin() + 1;
-                it != bus->stops.rend(); ++it) {
-                polyline.AddPoint(stop_coords.at((*it)->name));
+        if (!bus.is_annular) {
+            for (auto it = bus.stops.rbegin() + 1;
+                it != bus.stops.rend(); ++it) {
+                polyline.AddPoint(stop_coords.at(db.GetStop(*it).name));
             }
         }
 
@@ -197,7 +198,7 @@ namespace svg {
         const dom::Point& offset,
         const int font_size,
         const std::string& font_family,
-        const std::string& font_weight) {
+        const std::string& font_weight) const {
         return svg::Text()
             .SetPosition(coords)
             .SetOffset(offset)
@@ -211,7 +212,7 @@ namespace svg {
         const dom::Point& coords,
         const dom::Point& offset,
         const int font_size,
-        const std::string& font_family) {
+        const std::string& font_family) const {
         return svg::Text()
             .SetPosition(coords)
             .SetOffset(offset)
@@ -223,7 +224,7 @@ namespace svg {
     svg::Text MapRenderer::Substrate(const svg::Text& base_text,
         const dom::Color& fill_color,
         const dom::Color& stroke_color,
-        const double stroke_width) {
+        const double stroke_width) const {
         return svg::Text{ base_text }
             .SetFillColor(fill_color)
             .SetStrokeColor(stroke_color)
@@ -233,7 +234,7 @@ namespace svg {
     }
 
     svg::Text MapRenderer::Caption(const svg::Text& base_text,
-        const dom::Color& fill_color) {
+        const dom::Color& fill_color) const {
         return svg::Text{ base_text }
         .SetFillColor(fill_color);
     }
@@ -6,6 +6,7 @@
 
 #include <algorithm>
 #include <map>
+#include <set>
 
 namespace svg {
 
@@ -115,7 +116,8 @@ namespace svg {
     class MapRenderer {
     public:
 
-        const svg::Document RenderMap(const cat::TransportCatalogue& db);
+        const svg::Document RenderMap(
+            const cat::TransportCatalogue& db) const;
 
         dom::RouteMapSettings& GetRouteMapSettings();
 
@@ -124,32 +126,33 @@ namespace svg {
 
         std::map<std::string_view, dom::Point>
         StopCoords(const cat::TransportCatalogue& db,
-                   std::set<std::string_view>& sortered_bus_names);
+                   std::set<std::string_view>& sortered_bus_names) const;
 
-        svg::Polyline CreateRoute(const dom::Bus* bus,
+        svg::Polyline CreateRoute(const cat::TransportCatalogue& db,
+            const dom::Bus& bus,
             const std::map<std::string_view, dom::Point>& stop_coords,
             const dom::Color& fill_color,
             const dom::Color& stroke_color,
             const double stroke_width,
             const svg::StrokeLineCap stroke_line_cap,
-            const svg::StrokeLineJoin stroke_line_join);
+            const svg::StrokeLineJoin stroke_line_join) const;
         svg::Text BaseText(const std::string_view name,
             const dom::Point& coords,
             const dom::Point& offset,
             const int font_size,
             const std::string& font_family,
-            const std::string& font_weight);
+            const std::string& font_weight) const;
         svg::Text BaseText(const std::string_view name,
             const dom::Point& coords,
             const dom::Point& offset,
             const int font_size,
-            const std::string& font_family);
+            const std::string& font_family) const;
         svg::Text Substrate(const svg::Text& base_text,
             const dom::Color& fill_color,
             const dom::Color& stroke_color,
-            const double stroke_width);
+            const double stroke_width) const;
         svg::Text Caption(const svg::Text& base_text,
-            const dom::Color& fill_color);
+            const dom::Color& fill_color) const;
 
     };
 
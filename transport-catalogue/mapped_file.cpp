@@ -0,0 +1,70 @@
+#include "mapped_file.h"
+
+#if defined(_WIN32)
+#include <fstream>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace serialization {
+
+    MappedFile::~MappedFile() {
+#if !defined(_WIN32)
+        if (data_ != nullptr && !buffer_) {
+            munmap(const_cast<char*>(data_), size_);
+        }
+#endif
+    }
+
+    std::shared_ptr<const MappedFile> MappedFile::Open(
+        const std::filesystem::path& file) {
+
+        std::shared_ptr<MappedFile> result(new MappedFile());
+#if defined(_WIN32)
+        std::error_code error;
+        const auto size = std::filesystem::file_size(file, error);
+        std::ifstream in(file, std::ios::binary);
+        if (error || !in) {
+            return nullptr;
+        }
+        result->buffer_ = std::make_unique<char[]>(size);
+        if (!in.read(result->buffer_.get(), size)) {
+            return nullptr;
+        }
+        result->data_ = result->buffer_.get();
+        result->size_ = size;
+#else
+        const int descriptor = open(file.c_str(), O_RDONLY);
+        if (descriptor < 0) {
+            return nullptr;
+        }
+        struct stat status;
+        if (fstat(descriptor, &status) != 0 || status.st_size == 0) {
+            close(descriptor);
+            return nullptr;
+        }
+        void* data = mmap(nullptr, status.st_size, PROT_READ, MAP_SHARED,
+                          descriptor, 0);
+        // The mapping keeps the file open by itself.
+        close(descriptor);
+        if (data == MAP_FAILED) {
+            return nullptr;
+        }
+        result->data_ = static_cast<const char*>(data);
+        result->size_ = static_cast<size_t>(status.st_size);
+#endif
+        return result;
+    }
+
+    const char* MappedFile::GetData() const {
+        return data_;
+    }
+
+    size_t MappedFile::GetSize() const {
+        return size_;
+    }
+
+} // namespace serialization
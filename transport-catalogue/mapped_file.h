@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <memory>
+
+namespace serialization {
+
+    // Read-only mapping of a whole file into memory. Pages are read
+    // in on first access and shared with every other process mapping
+    // the same file.
+    class MappedFile {
+    public:
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+        ~MappedFile();
+
+        // nullptr if the file can not be mapped.
+        static std::shared_ptr<const MappedFile> Open(
+            const std::filesystem::path& file);
+
+        const char* GetData() const;
+        size_t GetSize() const;
+
+    private:
+        MappedFile() = default;
+
+        const char* data_ = nullptr;
+        size_t size_ = 0;
+        // Set where the file is read instead of mapped.
+        std::unique_ptr<char[]> buffer_;
+    };
+
+} // namespace serialization
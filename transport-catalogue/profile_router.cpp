@@ -0,0 +1,375 @@
+#include "profile_router.h"
+#include "transport_router.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <tuple>
+
+namespace cat {
+
+    const int MINUTES_PER_DAY = 24 * 60;
+    // Today and tomorrow, enough for journeys starting today.
+    const int UNROLLED_DAYS = 2;
+    const double INFINITE_TIME = std::numeric_limits<double>::infinity();
+
+    void ProfileRouter::Build(const TransportCatalogue& db,
+        const dom::RoutingSettings& routing_settings,
+        const std::vector<Walk>& walks) {
+
+        Clear();
+
+        const size_t stops_count = db.GetStopsList().size();
+        stops_names_.reserve(stops_count);
+        for (const auto& stop : db.GetStopsList()) {
+            stops_names_.push_back(stop.name);
+        }
+
+        walks_offsets_.assign(stops_count + 1, 0);
+        for (const auto& walk : walks) {
+            ++walks_offsets_[walk.to + 1];
+        }
+        for (size_t i = 0; i < stops_count; ++i) {
+            walks_offsets_[i + 1] += walks_offsets_[i];
+        }
+        walks_.resize(walks.size());
+        std::vector<uint32_t> positions(walks_offsets_.begin(),
+                                        walks_offsets_.end() - 1);
+        for (const auto& walk : walks) {
+            walks_[positions[walk.to]++] = walk;
+        }
+
+        double bus_speed =
+            routing_settings.bus_velocity *
+            dom::METERS_PER_MINUTE_PER_KMH;
+
+        // Buses without a timetable run all day long. A passenger
+        // coming at random waits half of the interval on average,
+        // so bus_wait_time corresponds to twice as long headway.
+        const std::vector<dom::Headway> default_headways = {
+            { 0, MINUTES_PER_DAY,
+              std::max(1, routing_settings.bus_wait_time * 2) } };
+
+        for (const auto& bus : db.GetBusesList()) {
+            const auto& bus_stops = bus.stops;
+            if (bus_stops.size() < 2) {
+                continue;
+            }
+            const auto& headways = bus.headways.empty()
+                ? default_headways : bus.headways;
+
+            std::vector<dom::StopId> stops(bus_stops.begin(),
+                                           bus_stops.end());
+            std::vector<double> offsets(bus_stops.size(), 0.0);
+            for (size_t i = 1; i < bus_stops.size(); ++i) {
+                offsets[i] = offsets[i - 1] +
+                    db.DistanceBetweenStops(bus_stops[i - 1],
+                                            bus_stops[i]) /
+                    bus_speed;
+            }
+            AddTrips({ bus.name, bus.id, std::nullopt },
+                     headways, stops, offsets);
+
+            if (bus.is_annular) {
+                continue;
+            }
+
+            // The way back starts from the final stop by the same
+            // timetable.
+            std::reverse(stops.begin(), stops.end());
+            for (size_t i = 1; i < bus_stops.size(); ++i) {
+                size_t s = bus_stops.size() - i;
+                offsets[i] = offsets[i - 1] +
+                    db.DistanceBetweenStops(bus_stops[s],
+                                            bus_stops[s - 1]) /
+                    bus_speed;
+            }
+            AddTrips({ bus.name, bus.id,
+                       static_cast<uint32_t>(bus_stops.size() - 1) },
+                     headways, stops, offsets);
+        }
+
+        std::sort(connections_.begin(), connections_.end(),
+            [](const Connection& lhs, const Connection& rhs) {
+                return std::tie(lhs.departure, lhs.trip, lhs.position) <
+                       std::tie(rhs.departure, rhs.trip, rhs.position);
+            });
+    }
+
+    std::vector<dom::ProfilePoint>
+    ProfileRouter::GetProfile(size_t from_id, size_t to_id,
+        double window_begin, double window_end,
+        const ScenarioMask& mask) const {
+
+        std::vector<dom::ProfilePoint> result;
+        if (from_id == to_id) {
+            return result;
+        }
+
+        // The scan runs in the times of the day the window begins.
+        const double day_start = GetDayStart(window_begin);
+        const auto profiles =
+            ScanProfiles(to_id, window_begin - day_start, mask);
+        const auto& profile = profiles[from_id];
+
+        // The first entry beyond the window still answers departures
+        // between the last breakpoint and the end of the window.
+        for (auto it = profile.rbegin(); it != profile.rend(); ++it) {
+            result.push_back({ it->departure + day_start,
+                               it->arrival + day_start });
+            if (it->departure + day_start >= window_end) {
+                break;
+            }
+        }
+
+        return result;
+    }
+
+    std::vector<dom::TripAction>
+    ProfileRouter::GetRoute(size_t from_id, size_t to_id,
+        double departure_time, const ScenarioMask& mask) const {
+
+        std::vector<dom::TripAction> result;
+        if (from_id == to_id || mask.IsStopClosed(from_id)) {
+            return result;
+        }
+
+        departure_time -= GetDayStart(departure_time);
+        const auto profiles = ScanProfiles(to_id, departure_time, mask);
+        const auto walks_to = GetWalksTo(to_id, mask);
+
+        dom::TripAction trip_action;
+        double time = departure_time;
+        size_t stop = from_id;
+        while (true) {
+            // Ties go to the walk, as in the scan.
+            const ProfileEntry* entry = Evaluate(profiles[stop], time);
+            const double walk_arrival = time + walks_to[stop];
+            if (walk_arrival != INFINITE_TIME &&
+                (entry == nullptr || walk_arrival <= entry->arrival)) {
+                trip_action.type = dom::ActionType::WALK;
+                trip_action.name = stops_names_[stop];
+                trip_action.to_stop = stops_names_[to_id];
+                trip_action.time = walks_to[stop];
+                result.push_back(trip_action);
+                break;
+            }
+            if (entry == nullptr) {
+                break;
+            }
+
+            const auto& enter = connections_[entry->enter];
+            const auto& exit = connections_[entry->exit];
+
+            if (enter.from != stop) {
+                trip_action.type = dom::ActionType::WALK;
+                trip_action.name = stops_names_[stop];
+                trip_action.to_stop = stops_names_[enter.from];
+                trip_action.time = enter.departure - entry->departure;
+                result.push_back(trip_action);
+                trip_action.to_stop.clear();
+            }
+
+            trip_action.type = dom::ActionType::WAIT;
+            trip_action.name = stops_names_[enter.from];
+            trip_action.span_count = 0;
+            trip_action.time = entry->departure - time;
+            result.push_back(trip_action);
+
+            trip_action.type = dom::ActionType::IN_BUS;
+            trip_action.name = trips_[enter.trip].bus_name;
+            trip_action.span_count =
+                static_cast<int>(exit.position - enter.position) + 1;
+            trip_action.time = exit.arrival - enter.departure;
+            result.push_back(trip_action);
+
+            time = exit.arrival;
+            if (exit.to == to_id) {
+                break;
+            }
+            stop = exit.to;
+        }
+
+        return result;
+    }
+
+    void ProfileRouter::Clear() {
+        connections_.clear();
+        trips_.clear();
+        stops_names_.clear();
+        walks_offsets_.clear();
+        walks_.clear();
+    }
+
+    // private:
+
+    void ProfileRouter::AddTrips(const Trip& trip,
+        const std::vector<dom::Headway>& headways,
+        const std::vector<dom::StopId>& stops,
+        const std::vector<double>& offsets) {
+
+        for (int day = 0; day < UNROLLED_DAYS; ++day) {
+            for (const auto& headway : headways) {
+                for (int start = headway.start; start < headway.end;
+                     start += headway.interval) {
+                    const auto trip_id =
+                        static_cast<uint32_t>(trips_.size());
+                    const double departure =
+                        day * MINUTES_PER_DAY + start;
+                    trips_.push_back(trip);
+                    for (size_t i = 0; i + 1 < stops.size(); ++i) {
+                        connections_.push_back({ stops[i], stops[i + 1],
+                            trip_id, static_cast<uint32_t>(i),
+                            departure + offsets[i],
+                            departure + offsets[i + 1] });
+                    }
+                }
+            }
+        }
+    }
+
+    std::vector<ProfileRouter::Profile>
+    ProfileRouter::ScanProfiles(size_t to_id, double window_begin,
+                                const ScenarioMask& mask) const {
+
+        std::vector<Profile> profiles(stops_names_.size());
+        if (mask.IsStopClosed(to_id)) {
+            return profiles;
+        }
+        const auto walks_to = GetWalksTo(to_id, mask);
+        // Earliest arrival to the target staying in a trip and the
+        // connection to leave the trip after.
+        std::vector<std::pair<double, size_t>>
+            trips(trips_.size(), { INFINITE_TIME, 0 });
+
+        const auto first = static_cast<size_t>(std::distance(
+            connections_.begin(),
+            std::lower_bound(connections_.begin(), connections_.end(),
+                window_begin,
+                [](const Connection& connection, double time) {
+                    return connection.departure < time;
+                })));
+
+        for (size_t i = connections_.size(); i > first; --i) {
+            const size_t connection_id = i - 1;
+            const auto& connection = connections_[connection_id];
+
+            double arrival = INFINITE_TIME;
+            size_t exit = connection_id;
+            auto& trip = trips[connection.trip];
+            // Nothing goes on over a closed hop.
+            if (!IsConnectionOpen(connection, mask)) {
+                trip = { INFINITE_TIME, 0 };
+                continue;
+            }
+            if (connection.to == to_id) {
+                arrival = connection.arrival;
+            }
+            else {
+                if (!mask.IsStopClosed(connection.to)) {
+                    arrival = connection.arrival + walks_to[connection.to];
+                    if (const auto* entry = Evaluate(
+                        profiles[connection.to], connection.arrival)) {
+                        arrival = std::min(arrival, entry->arrival);
+                    }
+                }
+                // Staying seated is preferred over a transfer.
+                if (trip.first <= arrival) {
+                    arrival = trip.first;
+                    exit = trip.second;
+                }
+            }
+
+            if (arrival == INFINITE_TIME) {
+                continue;
+            }
+            trip = { arrival, exit };
+
+            if (connection.from == to_id ||
+                mask.IsStopClosed(connection.from)) {
+                continue;
+            }
+            Insert(profiles[connection.from], { connection.departure,
+                arrival, connection_id, exit });
+
+            // Walking to the stop to board there.
+            for (uint32_t w = walks_offsets_[connection.from];
+                 w < walks_offsets_[connection.from + 1]; ++w) {
+                const auto& walk = walks_[w];
+                if (walk.from == to_id || mask.IsStopClosed(walk.from)) {
+                    continue;
+                }
+                Insert(profiles[walk.from], { connection.departure -
+                    walk.time, arrival, connection_id, exit });
+            }
+        }
+
+        return profiles;
+    }
+
+    std::vector<double> ProfileRouter::GetWalksTo(size_t to_id,
+        const ScenarioMask& mask) const {
+
+        std::vector<double> result(stops_names_.size(), INFINITE_TIME);
+        for (uint32_t w = walks_offsets_[to_id];
+             w < walks_offsets_[to_id + 1]; ++w) {
+            const auto& walk = walks_[w];
+            if (!mask.IsStopClosed(walk.from)) {
+                result[walk.from] = std::min(result[walk.from], walk.time);
+            }
+        }
+        return result;
+    }
+
+    bool ProfileRouter::IsConnectionOpen(const Connection& connection,
+        const ScenarioMask& mask) const {
+
+        if (mask.IsEmpty()) {
+            return true;
+        }
+        const auto& trip = trips_[connection.trip];
+        if (trip.back_from) {
+            const uint32_t from = *trip.back_from - connection.position;
+            return mask.IsRideOpen(trip.bus, from, from - 1);
+        }
+        return mask.IsRideOpen(trip.bus, connection.position,
+                               connection.position + 1);
+    }
+
+    void ProfileRouter::Insert(Profile& profile,
+                               const ProfileEntry& entry) {
+        // Entries departing later come first, their arrivals must be
+        // later too.
+        auto it = std::partition_point(profile.begin(), profile.end(),
+            [&entry](const ProfileEntry& other) {
+                return other.departure > entry.departure;
+            });
+        if (it != profile.begin() && (it - 1)->arrival <= entry.arrival) {
+            return;
+        }
+        if (it != profile.end() && it->departure == entry.departure &&
+            it->arrival <= entry.arrival) {
+            return;
+        }
+        // Entries departing earlier and arriving no sooner are dominated.
+        auto last = it;
+        while (last != profile.end() && last->arrival >= entry.arrival) {
+            ++last;
+        }
+        profile.insert(profile.erase(it, last), entry);
+    }
+
+    double ProfileRouter::GetDayStart(double time) {
+        return std::floor(time / MINUTES_PER_DAY) * MINUTES_PER_DAY;
+    }
+
+    const ProfileRouter::ProfileEntry*
+    ProfileRouter::Evaluate(const Profile& profile, double time) {
+        auto it = std::partition_point(profile.begin(), profile.end(),
+            [time](const ProfileEntry& entry) {
+                return entry.departure >= time;
+            });
+        return it == profile.begin() ? nullptr : &*(it - 1);
+    }
+
+} // namespace cat
@@ -0,0 +1,131 @@
+#pragma once
+
+#include "transport_catalogue.h"
+
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace cat {
+
+    struct ScenarioMask;
+
+    // Time-dependent router for buses running with headways.
+    // The timetable is unrolled into elementary connections (a bus
+    // trip between two consecutive stops) and a profile connection
+    // scan builds the arrival function "departure time -> arrival
+    // time" of every stop to the target in one pass.
+    //
+    // Times are minutes after midnight. A headway runs trips starting
+    // within [start, end). Every day runs the same timetable, so the
+    // trips of the next day are unrolled too: a departure after the
+    // last trip of the day takes the first one of the next day, and
+    // departure times beyond a day are taken modulo the day.
+    //
+    // Walks between nearby stops let a journey transfer to a bus at
+    // another stop, start by walking to a stop or end by walking to
+    // the target.
+    //
+    // A scenario mask is kept as in the static search: no rides of
+    // closed buses or over closed hops, no boarding, leaving buses or
+    // walks at closed stops.
+    class ProfileRouter {
+    public:
+
+        // A walk from one stop to another, in minutes.
+        struct Walk {
+            dom::StopId from = 0;
+            dom::StopId to = 0;
+            double time = 0.0;
+        };
+
+        void Build(const TransportCatalogue& db,
+                   const dom::RoutingSettings& routing_settings,
+                   const std::vector<Walk>& walks);
+
+        // Breakpoints answering departures within [window_begin,
+        // window_end], both bounds included, in the times of the
+        // window. Windows up to a day long are answered in full.
+        // A walk straight to the target has no breakpoints and is
+        // left out.
+        std::vector<dom::ProfilePoint>
+        GetProfile(size_t from_id, size_t to_id,
+                   double window_begin, double window_end,
+                   const ScenarioMask& mask) const;
+
+        std::vector<dom::TripAction>
+        GetRoute(size_t from_id, size_t to_id,
+                 double departure_time,
+                 const ScenarioMask& mask) const;
+
+        void Clear();
+
+    private:
+        struct Connection {
+            uint32_t from = 0;
+            uint32_t to = 0;
+            uint32_t trip = 0;
+            uint32_t position = 0;
+            double departure = 0.0;
+            double arrival = 0.0;
+        };
+
+        // Pareto-optimal journey from a stop: board connection
+        // `enter`, leave the bus after connection `exit`. When
+        // `enter` departs from another stop, the journey walks there
+        // first.
+        struct ProfileEntry {
+            double departure = 0.0;
+            double arrival = 0.0;
+            size_t enter = 0;
+            size_t exit = 0;
+        };
+        // Entries are kept by decreasing departure (and arrival).
+        using Profile = std::vector<ProfileEntry>;
+
+        struct Trip {
+            std::string_view bus_name;
+            dom::BusId bus = 0;
+            // Route position of the last stop when the trip goes from
+            // the final stop back, connection positions count from it.
+            std::optional<uint32_t> back_from;
+        };
+
+        std::vector<Connection> connections_;
+        std::vector<Trip> trips_;
+        std::vector<std::string_view> stops_names_;
+        // Walks into each stop: those into stop i are
+        // walks_[walks_offsets_[i]] to walks_[walks_offsets_[i + 1]].
+        std::vector<uint32_t> walks_offsets_;
+        std::vector<Walk> walks_;
+
+        void AddTrips(const Trip& trip,
+                      const std::vector<dom::Headway>& headways,
+                      const std::vector<dom::StopId>& stops,
+                      const std::vector<double>& offsets);
+
+        std::vector<Profile> ScanProfiles(size_t to_id,
+                                          double window_begin,
+                                          const ScenarioMask& mask) const;
+
+        // Time to walk from each open stop straight to `to_id`,
+        // infinite where there is no walk.
+        std::vector<double> GetWalksTo(size_t to_id,
+                                       const ScenarioMask& mask) const;
+
+        bool IsConnectionOpen(const Connection& connection,
+                              const ScenarioMask& mask) const;
+
+        // Keeps the profile Pareto-optimal.
+        static void Insert(Profile& profile, const ProfileEntry& entry);
+
+        // Midnight of the day `time` falls on.
+        static double GetDayStart(double time);
+
+        static const ProfileEntry* Evaluate(const Profile& profile,
+                                            double time);
+    };
+
+} // namespace cat
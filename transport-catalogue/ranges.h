@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstddef>
 #include <iterator>
 #include <string_view>
 #include <unordered_map>
@@ -22,6 +23,27 @@ namespace ranges {
         It end() const {
             return end_;
         }
+        std::reverse_iterator<It> rbegin() const {
+            return std::reverse_iterator<It>(end_);
+        }
+        std::reverse_iterator<It> rend() const {
+            return std::reverse_iterator<It>(begin_);
+        }
+        size_t size() const {
+            return static_cast<size_t>(std::distance(begin_, end_));
+        }
+        bool empty() const {
+            return begin_ == end_;
+        }
+        decltype(auto) operator[](size_t i) const {
+            return begin_[i];
+        }
+        decltype(auto) front() const {
+            return *begin_;
+        }
+        decltype(auto) back() const {
+            return *std::prev(end_);
+        }
 
     private:
         It begin_;
@@ -1,9 +1,12 @@
 #include "request_handler.h"
 
+// Matches returned by a StopSearch request without a limit.
+const size_t STOP_SEARCH_LIMIT = 10;
+
 RequestHandler::RequestHandler(json::Reader& reader,
-                               cat::TransportCatalogue& db,
-                               svg::MapRenderer& map_renderer,
-                               cat::TransportRouter& transport_router)
+                               const cat::TransportCatalogue& db,
+                               const svg::MapRenderer& map_renderer,
+                               const cat::TransportRouter& transport_router)
     : reader_(reader)
     , db_(db)
     , map_renderer_(map_renderer)
@@ -28,13 +31,18 @@ cat::TransportRouter& RequestHandler::GetTransportRouter() {
 }
 */
 
-const void RequestHandler::BuildRouter() const {
-    transport_router_.BuildGraph(db_);
-    transport_router_.SetRouterIsSet(true);
-}
-
 using namespace std::literals;
 
+bool RequestHandler::NeedsRouter() const {
+    const auto& requests = reader_.GetStatRequests();
+    return std::any_of(requests.begin(), requests.end(),
+        [](const dom::Query& request) {
+            return request.type == dom::QueryType::ROUTE ||
+                request.type == dom::QueryType::ROUTE_MATRIX ||
+                request.type == dom::QueryType::ANALYTICS;
+        });
+}
+
 const void RequestHandler::JSONout(std::ostream& out) const {
 
     json::Array root;
@@ -58,6 +66,21 @@ const void RequestHandler::JSONout(std::ostream& out) const {
         else if (request.type == dom::QueryType::ROUTE) {
             RouterInfo(request, blocks);
         }
+        else if (request.type == dom::QueryType::NEARBY_STOPS) {
+            NearbyStopsInfo(request, blocks);
+        }
+        else if (request.type == dom::QueryType::STOP_SEARCH) {
+            StopSearchInfo(request, blocks);
+        }
+        else if (request.type == dom::QueryType::ROUTE_MATRIX) {
+            RouteMatrixInfo(request, blocks);
+        }
+        else if (request.type == dom::QueryType::DIRECT_BUSES) {
+            DirectBusesInfo(request, blocks);
+        }
+        else if (request.type == dom::QueryType::ANALYTICS) {
+            AnalyticsInfo(request, blocks);
+        }
 
         root.push_back(std::move(json::Node(std::move(
             blocks))));
@@ -78,10 +101,10 @@ const void RequestHandler::StopInfo(const dom::Query& request,
         json::Array items;
         if (stop_info.buses.size() > 0) {
 
-            for (auto bus : stop_info.buses) {
+            for (const auto bus : stop_info.buses) {
                 items.push_back(
                     std::move(json::Node(
-                        bus->name)));
+                        std::string(db_.GetBus(bus).name))));
             }
 
         }
@@ -121,15 +144,24 @@ const void RequestHandler::BusInfo(const dom::Query& request,
 const void RequestHandler::RouterInfo(const dom::Query& request,
     json::Dict& blocks) const {
 
-    const auto& routing_settings =
-        transport_router_.GetRoutingSettings();
-    if (!transport_router_.RouterIsSet()) {
-        transport_router_.BuildGraph(db_);
-        transport_router_.SetRouterIsSet(true);
+    // Routes go from a point to a point, or from a stop to a stop.
+    if (request.from_point.has_value() != request.to_point.has_value()) {
+        blocks["error_message"s] = std::move(json::Node(
+            "from_point and to_point must be given together"s));
+        return;
     }
-    std::vector<dom::TripAction> actions;
-    actions = transport_router_.GetRoute(request.from_stop,
-        request.to_stop, routing_settings.bus_wait_time);
+    // Timetables are searched between stops only.
+    if ((request.from_point || request.to_point) &&
+        (request.departure_time || request.departure_window)) {
+        blocks["error_message"s] = std::move(json::Node(
+            "departure time is not supported between points"s));
+        return;
+    }
+    if (request.departure_window) {
+        ProfileInfo(request, blocks);
+        return;
+    }
+    std::vector<dom::TripAction> actions = GetTripActions(request);
 
     if (actions.size() > 0) {
 
@@ -148,6 +180,23 @@ const void RequestHandler::RouterInfo(const dom::Query& request,
                 total_time += action.time;
                 continue;
             }
+            if (action.type == dom::ActionType::WALK) {
+                items_dict["type"s] =
+                    std::move(json::Node("Walk"s));
+                if (!action.name.empty()) {
+                    items_dict["from"s] =
+                        std::move(json::Node(action.name));
+                }
+                if (!action.to_stop.empty()) {
+                    items_dict["to"s] =
+                        std::move(json::Node(action.to_stop));
+                }
+                items_dict["time"s] =
+                    std::move(json::Node(action.time));
+                items.push_back(json::Node(items_dict));
+                total_time += action.time;
+                continue;
+            }
             if (action.type == dom::ActionType::IN_BUS) {
                 items_dict["type"s] =
                     std::move(json::Node("Bus"s));
@@ -173,6 +222,137 @@ const void RequestHandler::RouterInfo(const dom::Query& request,
     }
 }
 
+const void RequestHandler::ProfileInfo(const dom::Query& request,
+    json::Dict& blocks) const {
+
+    const auto& [window_begin, window_end] = *request.departure_window;
+    const auto stops = GetQueryStops(request);
+    std::vector<dom::ProfilePoint> profile;
+    if (stops) {
+        profile = transport_router_.GetRouteProfile(stops->first,
+            stops->second, window_begin, window_end,
+            GetScenarioMask(request));
+    }
+
+    if (profile.size() > 0) {
+        json::Array items;
+        for (const auto& point : profile) {
+            json::Dict items_dict;
+            items_dict["departure_time"s] =
+                std::move(json::Node(point.departure_time));
+            items_dict["arrival_time"s] =
+                std::move(json::Node(point.arrival_time));
+            items_dict["total_time"s] =
+                std::move(json::Node(point.arrival_time -
+                                     point.departure_time));
+            items.push_back(json::Node(items_dict));
+        }
+        blocks["profile"s] =
+            std::move(json::Node(std::move(items)));
+    }
+    else {
+        blocks["error_message"s] =
+            std::move(json::Node("not found"s));
+    }
+}
+
+const void RequestHandler::NearbyStopsInfo(const dom::Query& request,
+    json::Dict& blocks) const {
+
+    // A missing radius is read as 0.
+    if (!(request.radius > 0.0)) {
+        blocks["error_message"s] = std::move(json::Node(
+            "radius must be positive"s));
+        return;
+    }
+
+    json::Array items;
+    for (const auto& [stop, distance] : GetNearbyStops(request)) {
+        json::Dict items_dict;
+        items_dict["stop_name"s] =
+            std::move(json::Node(std::string(db_.GetStop(stop).name)));
+        items_dict["distance"s] =
+            std::move(json::Node(distance));
+        items.push_back(json::Node(items_dict));
+    }
+    blocks["stops"s] =
+        std::move(json::Node(std::move(items)));
+}
+
+const void RequestHandler::StopSearchInfo(const dom::Query& request,
+    json::Dict& blocks) const {
+
+    json::Array items;
+    for (const auto stop : GetFoundStops(request)) {
+        items.push_back(
+            json::Node(std::string(db_.GetStop(stop).name)));
+    }
+    blocks["stops"s] =
+        std::move(json::Node(std::move(items)));
+}
+
+const void RequestHandler::RouteMatrixInfo(const dom::Query& request,
+    json::Dict& blocks) const {
+
+    json::Array rows;
+    for (const auto& times : GetRouteMatrix(request)) {
+        json::Array row;
+        for (const auto& time : times) {
+            row.push_back(time ? json::Node(*time) : json::Node());
+        }
+        rows.push_back(json::Node(std::move(row)));
+    }
+    blocks["matrix"s] =
+        std::move(json::Node(std::move(rows)));
+}
+
+const void RequestHandler::DirectBusesInfo(const dom::Query& request,
+    json::Dict& blocks) const {
+
+    const auto stops = GetQueryStops(request);
+    if (!stops) {
+        blocks["error_message"s] =
+            std::move(json::Node("not found"s));
+        return;
+    }
+
+    json::Array items;
+    for (const auto& direct_bus :
+        db_.DirectBuses(stops->first, stops->second)) {
+        json::Dict items_dict;
+        items_dict["bus"s] = std::move(json::Node(
+            std::string(db_.GetBus(direct_bus.bus).name)));
+        items_dict["span_count"s] =
+            std::move(json::Node(direct_bus.span_count));
+        items.push_back(json::Node(items_dict));
+    }
+    blocks["buses"s] =
+        std::move(json::Node(std::move(items)));
+}
+
+const void RequestHandler::AnalyticsInfo(const dom::Query& request,
+    json::Dict& blocks) const {
+
+    const auto stops = GetAnalyticsStops(request);
+    const auto& centrality = transport_router_.GetCentrality();
+
+    json::Array items;
+    for (const auto stop : stops) {
+        json::Dict items_dict;
+        items_dict["stop_name"s] =
+            std::move(json::Node(std::string(db_.GetStop(stop).name)));
+        items_dict["betweenness"s] =
+            std::move(json::Node(centrality.betweenness[stop]));
+        items_dict["mean_time"s] =
+            std::move(json::Node(centrality.mean_weight[stop]));
+        items_dict["reachable_stops"s] = std::move(json::Node(
+            static_cast<int>(centrality.reachable_count[stop])));
+        items.push_back(json::Node(items_dict));
+    }
+    blocks["stops"s] =
+        std::move(json::Node(std::move(items)));
+}
+
 const void RequestHandler::RenderMap(std::ostream& out) const {
     map_renderer_.RenderMap(db_).Render(out);
 }
@@ -198,6 +378,26 @@ const void RequestHandler::TXTout(std::ostream& out, int precision) const {
             RouterInfo(request, out);
             continue;
         }
+        if (request.type == dom::QueryType::NEARBY_STOPS) {
+            NearbyStopsInfo(request, out);
+            continue;
+        }
+        if (request.type == dom::QueryType::STOP_SEARCH) {
+            StopSearchInfo(request, out);
+            continue;
+        }
+        if (request.type == dom::QueryType::ROUTE_MATRIX) {
+            RouteMatrixInfo(request, out);
+            continue;
+        }
+        if (request.type == dom::QueryType::DIRECT_BUSES) {
+            DirectBusesInfo(request, out);
+            continue;
+        }
+        if (request.type == dom::QueryType::ANALYTICS) {
+            AnalyticsInfo(request, out);
+            continue;
+        }
         out << "Unknown request."sv << std::endl;
     }
 }
@@ -210,8 +410,8 @@ const void RequestHandler::StopInfo(const dom::Query& request,
     if (stop_info.exists) {
         if (stop_info.buses.size() > 0) {
             out << "buses"sv;
-            for (const auto& bus : stop_info.buses) {
-                out << " "sv << bus->name;
+            for (const auto bus : stop_info.buses) {
+                out << " "sv << db_.GetBus(bus).name;
             }
         }
         else {
@@ -245,17 +445,26 @@ const void RequestHandler::BusInfo(const dom::Query& request,
 const void RequestHandler::RouterInfo(const dom::Query& request,
     std::ostream& out) const {
 
-    const auto& routing_settings =
-        transport_router_.GetRoutingSettings();
+    // Routes go from a point to a point, or from a stop to a stop.
+    if (request.from_point.has_value() != request.to_point.has_value()) {
+        out << "error_message : "sv
+            << "from_point and to_point must be given together\n"sv;
+        return;
+    }
+    // Timetables are searched between stops only.
+    if ((request.from_point || request.to_point) &&
+        (request.departure_time || request.departure_window)) {
+        out << "error_message : "sv
+            << "departure time is not supported between points\n"sv;
+        return;
+    }
 
-    if (!transport_router_.RouterIsSet()) {
-        transport_router_.BuildGraph(db_);
-        transport_router_.SetRouterIsSet(true);
+    if (request.departure_window) {
+        ProfileInfo(request, out);
+        return;
     }
 
-    std::vector<dom::TripAction> actions;
-    actions = transport_router_.GetRoute(request.from_stop,
-        request.to_stop, routing_settings.bus_wait_time);
+    std::vector<dom::TripAction> actions = GetTripActions(request);
 
     if (actions.size() > 0) {
         double total_time = 0.0;
@@ -268,6 +477,18 @@ const void RequestHandler::RouterInfo(const dom::Query& request,
                 total_time += action.time;
                 continue;
             }
+            if (action.type == dom::ActionType::WALK) {
+                out << "  type       : Walk,\n"sv;
+                if (!action.name.empty()) {
+                    out << "  from       : "sv << action.name << ",\n"sv;
+                }
+                if (!action.to_stop.empty()) {
+                    out << "  to         : "sv << action.to_stop << ",\n"sv;
+                }
+                out << "  time       : "sv << action.time << "\n"sv;
+                total_time += action.time;
+                continue;
+            }
             if (action.type == dom::ActionType::IN_BUS) {
                 out << "  type       : Bus,\n"sv;
                 out << "  bus        : "sv << action.name << ",\n"sv;
@@ -282,4 +503,260 @@ const void RequestHandler::RouterInfo(const dom::Query& request,
     else {
         out << "error_message : not found\n"sv;
     }
+}
+
+const void RequestHandler::ProfileInfo(const dom::Query& request,
+    std::ostream& out) const {
+
+    const auto& [window_begin, window_end] = *request.departure_window;
+    const auto stops = GetQueryStops(request);
+    std::vector<dom::ProfilePoint> profile;
+    if (stops) {
+        profile = transport_router_.GetRouteProfile(stops->first,
+            stops->second, window_begin, window_end,
+            GetScenarioMask(request));
+    }
+
+    if (profile.size() > 0) {
+        out << "Profile : \n"sv;
+        for (const auto& point : profile) {
+            out << "  departure_time : "sv << point.departure_time
+                << ", arrival_time : "sv << point.arrival_time
+                << ", total_time : "sv
+                << point.arrival_time - point.departure_time << "\n"sv;
+        }
+    }
+    else {
+        out << "error_message : not found\n"sv;
+    }
+}
+
+const void RequestHandler::NearbyStopsInfo(const dom::Query& request,
+    std::ostream& out) const {
+
+    // A missing radius is read as 0.
+    if (!(request.radius > 0.0)) {
+        out << "error_message : radius must be positive\n"sv;
+        return;
+    }
+
+    const auto stops = GetNearbyStops(request);
+    if (stops.size() > 0) {
+        out << "Stops : \n"sv;
+        for (const auto& [stop, distance] : stops) {
+            out << "  stop_name : "sv << db_.GetStop(stop).name
+                << ", distance : "sv << distance << "\n"sv;
+        }
+    }
+    else {
+        out << "no stops\n"sv;
+    }
+}
+
+const void RequestHandler::StopSearchInfo(const dom::Query& request,
+    std::ostream& out) const {
+
+    const auto stops = GetFoundStops(request);
+    if (stops.size() > 0) {
+        out << "Stops : \n"sv;
+        for (const auto stop : stops) {
+            out << "  stop_name : "sv << db_.GetStop(stop).name << "\n"sv;
+        }
+    }
+    else {
+        out << "no stops\n"sv;
+    }
+}
+
+const void RequestHandler::RouteMatrixInfo(const dom::Query& request,
+    std::ostream& out) const {
+
+    const auto matrix = GetRouteMatrix(request);
+    for (size_t i = 0; i < matrix.size(); ++i) {
+        out << "from : "sv << request.from_stops[i] << "\n"sv;
+        for (size_t j = 0; j < matrix[i].size(); ++j) {
+            out << "  to : "sv << request.to_stops[j] << ", time : "sv;
+            if (matrix[i][j]) {
+                out << *matrix[i][j] << "\n"sv;
+            }
+            else {
+                out << "not found\n"sv;
+            }
+        }
+    }
+}
+
+const void RequestHandler::DirectBusesInfo(const dom::Query& request,
+    std::ostream& out) const {
+
+    const auto stops = GetQueryStops(request);
+    if (!stops) {
+        out << "error_message : not found\n"sv;
+        return;
+    }
+
+    const auto direct_buses =
+        db_.DirectBuses(stops->first, stops->second);
+    if (direct_buses.size() > 0) {
+        out << "Buses : \n"sv;
+        for (const auto& direct_bus : direct_buses) {
+            out << "  bus : "sv << db_.GetBus(direct_bus.bus).name
+                << ", span_count : "sv << direct_bus.span_count
+                << "\n"sv;
+        }
+    }
+    else {
+        out << "no buses\n"sv;
+    }
+}
+
+const void RequestHandler::AnalyticsInfo(const dom::Query& request,
+    std::ostream& out) const {
+
+    const auto stops = GetAnalyticsStops(request);
+    const auto& centrality = transport_router_.GetCentrality();
+    if (stops.size() > 0) {
+        out << "Stops : \n"sv;
+        for (const auto stop : stops) {
+            out << "  stop_name : "sv << db_.GetStop(stop).name
+                << ", betweenness : "sv << centrality.betweenness[stop]
+                << ", mean_time : "sv << centrality.mean_weight[stop]
+                << ", reachable_stops : "sv
+                << centrality.reachable_count[stop] << "\n"sv;
+        }
+    }
+    else {
+        out << "no stops\n"sv;
+    }
+}
+
+std::optional<std::pair<dom::StopId, dom::StopId>>
+RequestHandler::GetQueryStops(const dom::Query& request) const {
+
+    const auto from_stop = db_.GetStopId(request.from_stop);
+    const auto to_stop = db_.GetStopId(request.to_stop);
+    if (!from_stop || !to_stop) {
+        return std::nullopt;
+    }
+    return std::pair{ *from_stop, *to_stop };
+}
+
+std::vector<dom::TripAction> RequestHandler::GetTripActions(
+    const dom::Query& request) const {
+
+    const auto mask = GetScenarioMask(request);
+    if (request.from_point && request.to_point) {
+        return transport_router_.GetRoute(*request.from_point,
+                                          *request.to_point, mask);
+    }
+
+    const auto stops = GetQueryStops(request);
+    if (!stops) {
+        return {};
+    }
+
+    if (request.departure_time) {
+        return transport_router_.GetScheduledRoute(stops->first,
+            stops->second, *request.departure_time, mask);
+    }
+
+    if (!mask.IsEmpty()) {
+        return transport_router_.GetRoute(stops->first, stops->second,
+                                          mask);
+    }
+
+    const auto& routing_settings =
+        transport_router_.GetRoutingSettings();
+    return transport_router_.GetRoute(stops->first,
+        stops->second, routing_settings.bus_wait_time);
+}
+
+std::vector<std::pair<dom::StopId, double>> RequestHandler::GetNearbyStops(
+    const dom::Query& request) const {
+
+    if (!request.point) {
+        return {};
+    }
+    if (request.limit) {
+        return db_.NearbyStops(request.point->lat, request.point->lng,
+                               request.radius, *request.limit);
+    }
+    return db_.NearbyStops(request.point->lat, request.point->lng,
+                           request.radius);
+}
+
+std::vector<dom::StopId> RequestHandler::GetFoundStops(
+    const dom::Query& request) const {
+
+    return db_.SearchStops(request.prefix,
+        request.limit.value_or(STOP_SEARCH_LIMIT));
+}
+
+std::vector<std::vector<std::optional<double>>>
+RequestHandler::GetRouteMatrix(const dom::Query& request) const {
+
+    // Stops unknown to the catalogue get rows and columns of routes
+    // not found.
+    std::vector<dom::StopId> from_stops;
+    std::vector<size_t> from_rows;
+    for (size_t i = 0; i < request.from_stops.size(); ++i) {
+        if (const auto stop_id = db_.GetStopId(request.from_stops[i])) {
+            from_stops.push_back(*stop_id);
+            from_rows.push_back(i);
+        }
+    }
+    std::vector<dom::StopId> to_stops;
+    std::vector<size_t> to_columns;
+    for (size_t i = 0; i < request.to_stops.size(); ++i) {
+        if (const auto stop_id = db_.GetStopId(request.to_stops[i])) {
+            to_stops.push_back(*stop_id);
+            to_columns.push_back(i);
+        }
+    }
+
+    const auto found = transport_router_.GetRouteMatrix(from_stops,
+        to_stops, GetScenarioMask(request));
+
+    std::vector<std::vector<std::optional<double>>> result(
+        request.from_stops.size(),
+        std::vector<std::optional<double>>(request.to_stops.size()));
+    for (size_t i = 0; i < found.size(); ++i) {
+        for (size_t j = 0; j < found[i].size(); ++j) {
+            result[from_rows[i]][to_columns[j]] = found[i][j];
+        }
+    }
+    return result;
+}
+
+cat::ScenarioMask RequestHandler::GetScenarioMask(
+    const dom::Query& request) const {
+
+    if (!request.scenario) {
+        return {};
+    }
+    return transport_router_.MakeScenarioMask(db_, *request.scenario);
+}
+
+std::vector<dom::StopId> RequestHandler::GetAnalyticsStops(
+    const dom::Query& request) const {
+
+    const auto& betweenness =
+        transport_router_.GetCentrality().betweenness;
+
+    std::vector<dom::StopId> result(betweenness.size());
+    for (dom::StopId id = 0; id < result.size(); ++id) {
+        result[id] = id;
+    }
+    auto by_betweenness = [&](dom::StopId lhs, dom::StopId rhs) {
+        if (betweenness[lhs] != betweenness[rhs]) {
+            return betweenness[lhs] > betweenness[rhs];
+        }
+        return db_.GetStop(lhs).name < db_.GetStop(rhs).name;
+    };
+    const size_t limit = std::min(result.size(),
+        request.limit.value_or(result.size()));
+    std::partial_sort(result.begin(), result.begin() + limit,
+                      result.end(), by_betweenness);
+    result.resize(limit);
+    return result;
 }
\ No newline at end of file
@@ -3,6 +3,7 @@
 #include "json_builder.h"
 #include "json_reader.h"
 
+#include <algorithm>
 #include <iomanip>
 #include <iostream>
 #include <optional>
@@ -16,10 +17,12 @@
 class RequestHandler {
 public:
 
+    // The catalogue, the renderer and the router are only read: the
+    // router has to be built beforehand if NeedsRouter().
     RequestHandler(json::Reader& reader,
-        cat::TransportCatalogue& db,
-        svg::MapRenderer& map_renderer,
-        cat::TransportRouter& transport_router);
+        const cat::TransportCatalogue& db,
+        const svg::MapRenderer& map_renderer,
+        const cat::TransportRouter& transport_router);
 
 /*
     json::Reader& GetReader();
@@ -28,7 +31,8 @@ public:
     cat::TransportRouter& GetTransportRouter();
 */
 
-    const void BuildRouter() const;
+    // Whether the stat requests route over the graph.
+    bool NeedsRouter() const;
 
     const void JSONout(std::ostream& out) const;
     const void TXTout(std::ostream& out, int precision = 6) const;
@@ -36,9 +40,9 @@ public:
 
 private:
     json::Reader& reader_;
-    cat::TransportCatalogue& db_;
-    svg::MapRenderer& map_renderer_;
-    cat::TransportRouter& transport_router_;
+    const cat::TransportCatalogue& db_;
+    const svg::MapRenderer& map_renderer_;
+    const cat::TransportRouter& transport_router_;
 
     const void StopInfo(const dom::Query& request,
         json::Dict& blocks) const;
@@ -46,6 +50,18 @@ private:
         json::Dict& blocks) const;
     const void RouterInfo(const dom::Query& request,
         json::Dict& blocks) const;
+    const void ProfileInfo(const dom::Query& request,
+        json::Dict& blocks) const;
+    const void NearbyStopsInfo(const dom::Query& request,
+        json::Dict& blocks) const;
+    const void StopSearchInfo(const dom::Query& request,
+        json::Dict& blocks) const;
+    const void RouteMatrixInfo(const dom::Query& request,
+        json::Dict& blocks) const;
+    const void DirectBusesInfo(const dom::Query& request,
+        json::Dict& blocks) const;
+    const void AnalyticsInfo(const dom::Query& request,
+        json::Dict& blocks) const;
 
     const void StopInfo(const dom::Query& request,
         std::ostream& out) const;
@@ -53,4 +69,32 @@ private:
         std::ostream& out) const;
     const void RouterInfo(const dom::Query& request,
         std::ostream& out) const;
+    const void ProfileInfo(const dom::Query& request,
+        std::ostream& out) const;
+    const void NearbyStopsInfo(const dom::Query& request,
+        std::ostream& out) const;
+    const void StopSearchInfo(const dom::Query& request,
+        std::ostream& out) const;
+    const void RouteMatrixInfo(const dom::Query& request,
+        std::ostream& out) const;
+    const void DirectBusesInfo(const dom::Query& request,
+        std::ostream& out) const;
+    const void AnalyticsInfo(const dom::Query& request,
+        std::ostream& out) const;
+
+    // Stop names of a route request are looked up once here.
+    std::optional<std::pair<dom::StopId, dom::StopId>> GetQueryStops(
+        const dom::Query& request) const;
+    std::vector<dom::TripAction> GetTripActions(
+        const dom::Query& request) const;
+    std::vector<std::pair<dom::StopId, double>> GetNearbyStops(
+        const dom::Query& request) const;
+    std::vector<dom::StopId> GetFoundStops(
+        const dom::Query& request) const;
+    std::vector<std::vector<std::optional<double>>> GetRouteMatrix(
+        const dom::Query& request) const;
+    cat::ScenarioMask GetScenarioMask(const dom::Query& request) const;
+    // Stops by decreasing betweenness, at most `limit` of them.
+    std::vector<dom::StopId> GetAnalyticsStops(
+        const dom::Query& request) const;
 };
\ No newline at end of file
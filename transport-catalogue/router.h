@@ -21,6 +21,10 @@ namespace graph {
 
     public:
         explicit Router(const Graph& graph);
+        // Vertices of different groups are known to be disconnected,
+        // so their pairs are skipped while the tables are built.
+        Router(const Graph& graph,
+               const std::vector<uint32_t>& vertex_groups);
 
         struct RouteInfo {
             Weight weight;
@@ -80,14 +84,13 @@ namespace graph {
         }
 
         void RelaxRoutesInternalDataThroughVertex(
-            size_t vertex_count, VertexId vertex_through) {
-            for (VertexId vertex_from = 0;
-                 vertex_from < vertex_count; ++vertex_from) {
+            const std::vector<VertexId>& vertices,
+            VertexId vertex_through) {
+            for (const VertexId vertex_from : vertices) {
                 if (const auto& route_from = 
                     routes_internal_data_
                         [vertex_from][vertex_through]) {
-                    for (VertexId vertex_to = 0; 
-                         vertex_to < vertex_count; ++vertex_to) {
+                    for (const VertexId vertex_to : vertices) {
                         if (const auto& route_to = 
                             routes_internal_data_
                                 [vertex_through][vertex_to]) {
@@ -106,6 +109,13 @@ namespace graph {
 
     template <typename Weight>
     Router<Weight>::Router(const Graph& graph)
+        : Router(graph,
+                 std::vector<uint32_t>(graph.GetVertexCount(), 0))
+    {}
+
+    template <typename Weight>
+    Router<Weight>::Router(const Graph& graph,
+                           const std::vector<uint32_t>& vertex_groups)
         : graph_(graph)
         , routes_internal_data_(graph.GetVertexCount(),
             std::vector<std::optional<RouteInternalData>>(
@@ -113,12 +123,21 @@ namespace graph {
     {
         InitializeRoutesInternalData(graph);
 
+        std::vector<std::vector<VertexId>> groups;
         const size_t vertex_count = graph.GetVertexCount();
+        for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+            const size_t group = vertex_groups.at(vertex);
+            if (groups.size() <= group) {
+                groups.resize(group + 1);
+            }
+            groups[group].push_back(vertex);
+        }
+
         for (VertexId vertex_through = 0;
              vertex_through < vertex_count;
              ++vertex_through) {
             RelaxRoutesInternalDataThroughVertex(
-                vertex_count, vertex_through);
+                groups[vertex_groups[vertex_through]], vertex_through);
         }
     }
 
@@ -4,78 +4,532 @@ using namespace std::literals;
 
 namespace serialization {
 
+    // base_size, a fixed64 field with its tag, opens every base.
+    const size_t BASE_SIZE_FIELD_SIZE = 9;
+    // The log is folded into the base once it outgrows this share of
+    // the base.
+    const double LOG_COMPACTION_RATIO = 0.5;
+    // Stops or distances in one chunk of columns.
+    const size_t COLUMNS_CHUNK_SIZE = 4096;
+    // Fixed-point units of the coordinates in a columnar base.
+    const double COORDINATE_SCALE = 1e7;
+
+    namespace {
+
+        using Base = cat_proto::TransportCatalogueBase;
+
+        // What the sections of a base are read into. The threads
+        // reading the distances and the buses only read it, see
+        // SectionBuffer.
+        struct LoadState {
+            cat::CatalogueBuilder builder;
+            // Stops are referred to by their index in the base.
+            std::vector<dom::StopId> stops;
+            ColumnsCursor cursor;
+            Base settings;
+            uint64_t file_size = 0;
+            bool has_log = false;
+        };
+
+        // Every field is written, zero or not, so the header keeps its
+        // size when it is written again over the first one.
+        void WriteHeader(BaseWriter& writer, const Base& header) {
+            writer.WriteFixed64(Base::kBaseSizeFieldNumber,
+                                header.base_size());
+            writer.WriteFixed64(Base::kStopsOffsetFieldNumber,
+                                header.stops_offset());
+            writer.WriteFixed64(Base::kDistancesOffsetFieldNumber,
+                                header.distances_offset());
+            writer.WriteFixed64(Base::kBusesOffsetFieldNumber,
+                                header.buses_offset());
+            writer.WriteFixed64(Base::kSettingsOffsetFieldNumber,
+                                header.settings_offset());
+            writer.WriteFixed64(Base::kStopsCountFieldNumber,
+                                header.stops_count());
+            writer.WriteFixed64(Base::kDistancesCountFieldNumber,
+                                header.distances_count());
+            writer.WriteFixed64(Base::kBusesCountFieldNumber,
+                                header.buses_count());
+            writer.WriteFixed64(Base::kRouteStopsCountFieldNumber,
+                                header.route_stops_count());
+        }
+
+        // The fixed64 fields the base opens with; those of a base
+        // written before the section table stay 0.
+        Base ReadHeader(const Path& file) {
+            Base header;
+            std::ifstream in(file, std::ios::binary);
+            BaseReader reader(in);
+            while (const int field = reader.NextField()) {
+                uint64_t value = 0;
+                if (field < Base::kBaseSizeFieldNumber ||
+                    field == Base::kDeltasFieldNumber ||
+                    field == Base::kStopColumnsFieldNumber ||
+                    field == Base::kDistanceColumnsFieldNumber ||
+                    !reader.ReadFixed64(value)) {
+                    break;
+                }
+                switch (field) {
+                case Base::kBaseSizeFieldNumber:
+                    header.set_base_size(value);
+                    break;
+                case Base::kStopsOffsetFieldNumber:
+                    header.set_stops_offset(value);
+                    break;
+                case Base::kDistancesOffsetFieldNumber:
+                    header.set_distances_offset(value);
+                    break;
+                case Base::kBusesOffsetFieldNumber:
+                    header.set_buses_offset(value);
+                    break;
+                case Base::kSettingsOffsetFieldNumber:
+                    header.set_settings_offset(value);
+                    break;
+                case Base::kStopsCountFieldNumber:
+                    header.set_stops_count(value);
+                    break;
+                case Base::kDistancesCountFieldNumber:
+                    header.set_distances_count(value);
+                    break;
+                case Base::kBusesCountFieldNumber:
+                    header.set_buses_count(value);
+                    break;
+                case Base::kRouteStopsCountFieldNumber:
+                    header.set_route_stops_count(value);
+                    break;
+                }
+            }
+            return header;
+        }
+
+        // Distances and buses of a section read on a thread of its own.
+        // The builder is not shared between threads, so they are added
+        // to it once the threads are joined.
+        struct SectionBuffer {
+            struct Distance {
+                dom::StopId from = 0;
+                dom::StopId to = 0;
+                int distance = 0;
+            };
+            struct Bus {
+                std::string name;
+                bool is_annular = false;
+                std::vector<dom::Headway> headways;
+                std::vector<dom::StopId> stops;
+                std::optional<dom::BusStats> stats;
+            };
+
+            std::vector<Distance> distances;
+            std::vector<Bus> buses;
+        };
+
+        // Throws std::invalid_argument for a stop which is not added.
+        void AddBus(const SectionBuffer::Bus& bus,
+                    cat::CatalogueBuilder& builder) {
+            const auto bus_id = builder.AddBus(bus.name, bus.is_annular,
+                                               bus.headways);
+            for (const auto stop : bus.stops) {
+                builder.AddBusStop(stop);
+            }
+            if (bus.stats) {
+                builder.SetBusStats(bus_id, *bus.stats);
+            }
+        }
+
+        // Returns false for a stop which is not added.
+        bool AddBuffered(const SectionBuffer& buffer,
+                         cat::CatalogueBuilder& builder) {
+            try {
+                for (const auto& distance : buffer.distances) {
+                    builder.AddStopDistance(distance.from, distance.to,
+                                            distance.distance);
+                }
+                for (const auto& bus : buffer.buses) {
+                    AddBus(bus, builder);
+                }
+            }
+            catch (const std::invalid_argument&) {
+                return false;
+            }
+            return true;
+        }
+
+        // Every element goes to the builder right away, or to `buffer`
+        // if given; the messages are reused from one element to the
+        // next.
+        bool ReadFields(BaseReader& reader, LoadState& state,
+                        SectionBuffer* buffer) {
+            cat_proto::Stop stop_proto;
+            cat_proto::Distance distance_proto;
+            cat_proto::Bus bus_proto;
+            cat_proto::StopColumns stop_columns;
+            cat_proto::DistanceColumns distance_columns;
+            cat_proto::BaseDelta delta_proto;
+            uint64_t base_size = 0;
+            auto& builder = state.builder;
+            auto& stops = state.stops;
+            auto& cursor = state.cursor;
+            auto stop_at = [&stops](uint32_t index) {
+                return index < stops.size()
+                    ? stops[index] : static_cast<dom::StopId>(stops.size());
+            };
+            auto add_distance = [&builder, buffer](dom::StopId from,
+                                                   dom::StopId to,
+                                                   int distance) {
+                if (buffer != nullptr) {
+                    buffer->distances.push_back({ from, to, distance });
+                }
+                else {
+                    builder.AddStopDistance(from, to, distance);
+                }
+            };
+
+            while (const int field = reader.NextField()) {
+                bool is_read = true;
+                switch (field) {
+                case Base::kBaseSizeFieldNumber:
+                    // Written as 0 and set once the base is complete,
+                    // so a 0 marks a base cut short.
+                    is_read = reader.ReadFixed64(base_size) &&
+                        base_size > 0;
+                    // Changes in the log may touch any route, so the
+                    // statistics and the components are computed anew.
+                    state.has_log = base_size > 0 &&
+                        base_size < state.file_size;
+                    break;
+                case Base::kStopsFieldNumber:
+                    is_read = reader.ReadMessage(stop_proto);
+                    if (is_read) {
+                        stops.push_back(builder.AddStop(stop_proto.name(),
+                            stop_proto.latitude(), stop_proto.longitude()));
+                    }
+                    break;
+                case Base::kStopColumnsFieldNumber: {
+                    is_read = reader.ReadMessage(stop_columns);
+                    const auto coordinates = is_read
+                        ? RestoreFromColumns(stop_columns, cursor)
+                        : std::nullopt;
+                    is_read = coordinates.has_value();
+                    for (int i = 0; is_read && i < stop_columns.names_size();
+                         ++i) {
+                        stops.push_back(builder.AddStop(
+                            stop_columns.names(i), (*coordinates)[i].lat,
+                            (*coordinates)[i].lng));
+                    }
+                    break;
+                }
+                case Base::kRoadDistancesFieldNumber:
+                    is_read = reader.ReadMessage(distance_proto);
+                    if (is_read) {
+                        add_distance(stop_at(distance_proto.from_stop_id()),
+                                     stop_at(distance_proto.to_stop_id()),
+                                     distance_proto.distance());
+                    }
+                    break;
+                case Base::kDistanceColumnsFieldNumber: {
+                    is_read = reader.ReadMessage(distance_columns);
+                    const int count = distance_columns.distances_size();
+                    is_read = is_read &&
+                        distance_columns.from_stop_ids_size() == count &&
+                        distance_columns.to_stop_ids_size() == count;
+                    for (int i = 0; is_read && i < count; ++i) {
+                        cursor.from_stop += distance_columns.from_stop_ids(i);
+                        const uint32_t to =
+                            cursor.from_stop + distance_columns.to_stop_ids(i);
+                        add_distance(stop_at(cursor.from_stop), stop_at(to),
+                                     distance_columns.distances(i));
+                    }
+                    break;
+                }
+                case Base::kBusesFieldNumber: {
+                    is_read = reader.ReadMessage(bus_proto);
+                    if (!is_read) {
+                        break;
+                    }
+                    SectionBuffer::Bus bus;
+                    bus.name = bus_proto.name();
+                    bus.is_annular = bus_proto.is_annular();
+                    bus.headways.reserve(bus_proto.headways_size());
+                    for (const auto& headway : bus_proto.headways()) {
+                        bus.headways.push_back({ headway.start(),
+                            headway.end(), headway.interval() });
+                        is_read = is_read &&
+                            dom::IsValid(bus.headways.back());
+                    }
+                    if (!is_read) {
+                        break;
+                    }
+                    bus.stops.reserve(bus_proto.stop_ids_size());
+                    for (const auto index : bus_proto.stop_ids()) {
+                        bus.stops.push_back(stop_at(index));
+                    }
+                    if (bus_proto.has_stats() && !state.has_log) {
+                        const auto& stats = bus_proto.stats();
+                        bus.stats = dom::BusStats{ stats.route_stops(),
+                            stats.unique_stops(), stats.length(),
+                            stats.curvature() };
+                    }
+                    if (buffer != nullptr) {
+                        buffer->buses.push_back(std::move(bus));
+                    }
+                    else {
+                        AddBus(bus, builder);
+                    }
+                    break;
+                }
+                case Base::kRouteMapSettingsFieldNumber:
+                    is_read = reader.ReadMessage(
+                        *state.settings.mutable_route_map_settings());
+                    break;
+                case Base::kRoutingSettingsFieldNumber:
+                    is_read = reader.ReadMessage(
+                        *state.settings.mutable_routing_settings());
+                    break;
+                case Base::kComponentsFieldNumber:
+                    is_read = reader.ReadMessage(
+                        *state.settings.mutable_components());
+                    break;
+                case Base::kDeltasFieldNumber:
+                    // The log follows the base, so it is replayed in turn.
+                    is_read = reader.ReadMessage(delta_proto);
+                    if (is_read) {
+                        ApplyDelta(delta_proto, builder);
+                    }
+                    break;
+                default:
+                    is_read = reader.SkipField();
+                    break;
+                }
+                if (!is_read) {
+                    return false;
+                }
+            }
+            return reader.IsAtEnd();
+        }
+
+        // Reads the bytes [begin, end) of the file. Returns false as
+        // well if they refer to a stop which is not in the base.
+        bool ReadSection(const Path& file, uint64_t begin, uint64_t end,
+                         LoadState& state, SectionBuffer* buffer = nullptr) {
+            std::ifstream in(file, std::ios::binary);
+            if (!in.seekg(begin)) {
+                return false;
+            }
+            BaseReader reader(in, end - begin);
+            try {
+                return ReadFields(reader, state, buffer);
+            }
+            catch (const std::invalid_argument&) {
+                return false;
+            }
+        }
+
+    } // namespace
+
     //------------------------- Seriliazation -------------------------//
 
-    void Portal::Serialize(const Path& file,
+    bool Portal::Serialize(const Path& file,
                            cat::TransportCatalogue& db,
                            svg::MapRenderer& map_renderer,
                            cat::TransportRouter& transport_router) const {
 
-        std::ofstream out(file, std::ios::binary);
-        cat_proto::TransportCatalogueBase destination;
-
-//        std::unordered_map<std::string_view, size_t>& 
-//        stops_ids = router.GetStopsIds();
-//        if (!db.RouterIsSet()) {
-//            router.BuildGraph(db);
-//            db.SetRouterIsSet(true);
-//        }
- 
-        const std::unordered_map<std::string_view, dom::Stop*>&
-        stops = db.GetStops();
-        const cat::MapStopsDistance&
-        distances = db.GetDistances();
-        const std::unordered_map<std::string_view, dom::Bus*>&
-        buses = db.GetBuses();
-
-        for (const auto& [_, stop] : stops) {
-            cat_proto::Stop* stop_proto = destination.add_stops();
-            stop_proto->set_id(reinterpret_cast<size_t>(stop));
-            stop_proto->set_name(stop->name);
-            stop_proto->set_latitude(stop->latitude);
-            stop_proto->set_longitude(stop->longitude);
+        if (serialization_settings_.format == dom::BaseFormat::FLAT) {
+            cat_proto::TransportCatalogueBase settings;
+            StoreSettings(settings, map_renderer, transport_router);
+            return FlatBase::Write(file, db, settings);
+        }
 
-        //    if (send_router) {
-        //        stop_proto->set_id(transport_router.GetStopsIds().at(stop->name));
-        //    }
-        //    else {
-        //        stop_proto->set_id(reinterpret_cast<size_t>(stop));
-        //    }
+        const std::vector<dom::Stop>& stops = db.GetStopsList();
+        const cat::DistanceTable& distances = db.GetDistances();
+        const std::vector<dom::Bus>& buses = db.GetBusesList();
+
+        Base header;
+        header.set_stops_count(stops.size());
+        header.set_distances_count(distances.GetSize());
+        header.set_buses_count(buses.size());
+        uint64_t route_stops_count = 0;
+        for (const auto& bus : buses) {
+            route_stops_count += bus.stops.size();
         }
+        header.set_route_stops_count(route_stops_count);
+
+        Path temp_file = file;
+        temp_file += ".tmp"s;
+        std::ofstream out(temp_file, std::ios::binary);
+        {
+            // Every element, or chunk of columns, is written as soon
+            // as it is converted, so only one is in memory at a time.
+            BaseWriter writer(out);
+            // The offsets are not known yet, the header is written
+            // again below.
+            WriteHeader(writer, header);
+            header.set_stops_offset(writer.GetByteCount());
+
+            // Stops go in the order of their ids, which the distances
+            // and the buses refer to. Distances filled in for the
+            // reverse direction are not written, they are restored by
+            // Finalize.
+            if (serialization_settings_.format ==
+                dom::BaseFormat::COLUMNAR) {
+                for (size_t begin = 0; begin < stops.size();
+                     begin += COLUMNS_CHUNK_SIZE) {
+                    writer.WriteMessage(Base::kStopColumnsFieldNumber,
+                        ConvertToColumns(stops, begin, std::min(
+                            stops.size(), begin + COLUMNS_CHUNK_SIZE)));
+                }
+                header.set_distances_offset(writer.GetByteCount());
+                const auto values = SortDistances(distances);
+                for (size_t begin = 0; begin < values.size();
+                     begin += COLUMNS_CHUNK_SIZE) {
+                    writer.WriteMessage(Base::kDistanceColumnsFieldNumber,
+                        ConvertToColumns(values, begin, std::min(
+                            values.size(), begin + COLUMNS_CHUNK_SIZE)));
+                }
+            }
+            else {
+                cat_proto::Stop stop_proto;
+                for (const auto& stop : stops) {
+                    stop_proto.set_name(std::string(stop.name));
+                    stop_proto.set_latitude(stop.latitude);
+                    stop_proto.set_longitude(stop.longitude);
+                    writer.WriteMessage(Base::kStopsFieldNumber, stop_proto);
+                }
+                header.set_distances_offset(writer.GetByteCount());
+
+                cat_proto::Distance distance_proto;
+                distances.ForEach(
+                    [&writer, &distance_proto](dom::StopId from,
+                                               dom::StopId to,
+                                               int distance) {
+                        distance_proto.set_from_stop_id(from);
+                        distance_proto.set_to_stop_id(to);
+                        distance_proto.set_distance(distance);
+                        writer.WriteMessage(Base::kRoadDistancesFieldNumber,
+                                            distance_proto);
+                    });
+            }
 
+            header.set_buses_offset(writer.GetByteCount());
+            cat_proto::Bus bus_proto;
+            for (const auto& bus : buses) {
+                bus_proto.Clear();
+                bus_proto.set_name(std::string(bus.name));
+                bus_proto.set_is_annular(bus.is_annular);
+                for (const auto stop : bus.stops) {
+                    bus_proto.add_stop_ids(stop);
+                }
+                for (const auto& headway : bus.headways) {
+                    cat_proto::Headway* headway_proto =
+                        bus_proto.add_headways();
+                    headway_proto->set_start(headway.start);
+                    headway_proto->set_end(headway.end);
+                    headway_proto->set_interval(headway.interval);
+                }
+                if (bus.stats) {
+                    cat_proto::BusStats* stats_proto =
+                        bus_proto.mutable_stats();
+                    stats_proto->set_route_stops(bus.stats->route_stops);
+                    stats_proto->set_unique_stops(bus.stats->unique_stops);
+                    stats_proto->set_length(bus.stats->length);
+                    stats_proto->set_curvature(bus.stats->curvature);
+                }
+                writer.WriteMessage(Base::kBusesFieldNumber, bus_proto);
+            }
 
-        for (const auto& [key, value] : distances) {
-            cat_proto::Distance* distance_proto = 
-                destination.add_road_distances();
+            header.set_settings_offset(writer.GetByteCount());
+            Base settings;
+            StoreSettings(settings, map_renderer, transport_router);
+            writer.WriteMessage(Base::kRouteMapSettingsFieldNumber,
+                                settings.route_map_settings());
+            writer.WriteMessage(Base::kRoutingSettingsFieldNumber,
+                                settings.routing_settings());
+            if (settings.has_components()) {
+                writer.WriteMessage(Base::kComponentsFieldNumber,
+                                    settings.components());
+            }
+            header.set_base_size(writer.GetByteCount());
+        }
 
-//            auto i = transport_router.GetStopsIds().at(key.first->name);
+        out.seekp(0);
+        {
+            BaseWriter writer(out);
+            WriteHeader(writer, header);
+        }
+        out.close();
+        std::error_code error;
+        if (!out) {
+            std::filesystem::remove(temp_file, error);
+            return false;
+        }
+        std::filesystem::rename(temp_file, file, error);
+        if (error) {
+            std::filesystem::remove(temp_file, error);
+            return false;
+        }
+        return true;
+    }
 
-            const auto from_stop =
-                reinterpret_cast<size_t>(key.first);
-            const auto to_stop =
-                reinterpret_cast<size_t>(key.second);
+    bool Portal::AppendDelta(const Path& file,
+                             const dom::BaseDelta& delta) const {
 
-            distance_proto->set_from_stop_id(from_stop);
-            distance_proto->set_to_stop_id(to_stop);
-            distance_proto->set_distance(value);
+        if (FlatBase::IsFlat(file)) {
+            throw std::invalid_argument(
+                "Changes can not be logged to a flat base"s);
         }
-
-        for (const auto& [_, bus] : buses) {
-            cat_proto::Bus* bus_proto = destination.add_buses();
-            bus_proto->set_name(bus->name);
-            bus_proto->set_is_annular(bus->is_annular);
-            for (const auto& stop : bus->stops) {
-                bus_proto->add_stop_ids(reinterpret_cast<size_t>(stop));
+        // The base is copied as it is, not parsed, and the entry is
+        // appended to the copy, so readers of the base never see an
+        // entry half-written.
+        Path temp_file = file;
+        temp_file += ".tmp"s;
+        std::error_code error;
+        std::filesystem::copy_file(file, temp_file,
+            std::filesystem::copy_options::overwrite_existing, error);
+        if (error) {
+            std::filesystem::remove(temp_file, error);
+            return false;
+        }
+        {
+            std::ofstream out(temp_file, std::ios::binary | std::ios::app);
+            cat_proto::TransportCatalogueBase log;
+            *log.add_deltas() = ConvertToProto(delta);
+            log.SerializeToOstream(&out);
+            out.close();
+            if (!out) {
+                std::filesystem::remove(temp_file, error);
+                return false;
             }
         }
+        std::filesystem::rename(temp_file, file, error);
+        if (error) {
+            std::filesystem::remove(temp_file, error);
+            return false;
+        }
+        return true;
+    }
 
-        *destination.mutable_route_map_settings() = 
-            ConvertToProto(map_renderer.GetRouteMapSettings());
+    bool Portal::IsLogOversized(const Path& file) const {
+        if (FlatBase::IsFlat(file)) {
+            return false;
+        }
+        std::error_code error;
+        const auto file_size = std::filesystem::file_size(file, error);
+        if (error) {
+            return false;
+        }
 
-        *destination.mutable_routing_settings() = 
-            ConvertToProto(transport_router.GetRoutingSettings());
+        std::ifstream in(file, std::ios::binary);
+        std::string buffer(BASE_SIZE_FIELD_SIZE, '\0');
+        in.read(buffer.data(), BASE_SIZE_FIELD_SIZE);
+        cat_proto::TransportCatalogueBase header;
+        if (!in || !header.ParseFromString(buffer) ||
+            header.base_size() == 0 || header.base_size() > file_size) {
+            // A base written before the header existed.
+            return true;
+        }
 
-        destination.SerializeToOstream(&out);
+        const auto base_size = header.base_size();
+        return static_cast<double>(file_size - base_size) >
+            LOG_COMPACTION_RATIO * static_cast<double>(base_size);
     }
 
     cat_proto::RouteMapSettings ConvertToProto(
@@ -165,67 +619,230 @@ namespace serialization {
         cat_proto::RoutingSettings routing_settings_proto;
         routing_settings_proto.set_bus_velocity(routing_settings.bus_velocity);
         routing_settings_proto.set_bus_wait_time(routing_settings.bus_wait_time);
+        routing_settings_proto.
+            set_walking_velocity(routing_settings.walking_velocity);
+        routing_settings_proto.
+            set_walking_radius(routing_settings.walking_radius);
+        routing_settings_proto.
+            set_transfer_radius(routing_settings.transfer_radius);
 
         return routing_settings_proto;
     }
 
+    cat_proto::Components ConvertToProto(
+        const graph::Components& components) {
+
+        cat_proto::Components components_proto;
+        *components_proto.mutable_strong() =
+            { components.strong.begin(), components.strong.end() };
+        *components_proto.mutable_weak() =
+            { components.weak.begin(), components.weak.end() };
+        components_proto.set_strong_count(components.strong_count);
+        components_proto.set_weak_count(components.weak_count);
+        *components_proto.mutable_closure() =
+            { components.closure.begin(), components.closure.end() };
+
+        return components_proto;
+    }
+
+    cat_proto::BaseDelta ConvertToProto(const dom::BaseDelta& delta) {
+
+        cat_proto::BaseDelta delta_proto;
+        for (const auto& stop : delta.stops) {
+            cat_proto::StopDelta* stop_proto = delta_proto.add_stops();
+            stop_proto->set_name(stop.name);
+            stop_proto->set_remove(stop.remove);
+            stop_proto->set_latitude(stop.latitude);
+            stop_proto->set_longitude(stop.longitude);
+        }
+
+        for (const auto& distance : delta.distances) {
+            cat_proto::DistanceDelta* distance_proto =
+                delta_proto.add_road_distances();
+            distance_proto->set_from_stop(distance.from_stop);
+            distance_proto->set_to_stop(distance.to_stop);
+            distance_proto->set_distance(distance.distance);
+            distance_proto->set_remove(distance.remove);
+        }
+
+        for (const auto& bus : delta.buses) {
+            cat_proto::BusDelta* bus_proto = delta_proto.add_buses();
+            bus_proto->set_name(bus.name);
+            bus_proto->set_remove(bus.remove);
+            bus_proto->set_is_annular(bus.is_annular);
+            for (const auto& stop : bus.stops) {
+                bus_proto->add_stops(stop);
+            }
+            for (const auto& headway : bus.headways) {
+                cat_proto::Headway* headway_proto =
+                    bus_proto->add_headways();
+                headway_proto->set_start(headway.start);
+                headway_proto->set_end(headway.end);
+                headway_proto->set_interval(headway.interval);
+            }
+        }
+
+        return delta_proto;
+    }
+
     //------------------------ Deseriliazation ------------------------//
 
-    void Portal::Deserialize(const Path& file,
+    bool Portal::Deserialize(const Path& file,
         cat::TransportCatalogue& db,
         svg::MapRenderer& map_renderer,
         cat::TransportRouter& transport_router) const {
 
-        std::ifstream in(file, std::ios::binary);
-        cat_proto::TransportCatalogueBase source;
+        if (FlatBase::IsFlat(file)) {
+            cat_proto::TransportCatalogueBase settings;
+            if (!FlatBase::Read(file, db, settings)) {
+                return false;
+            }
+            // Stops are kept in the catalogue order.
+            std::vector<int> order(db.GetStopsList().size());
+            for (size_t i = 0; i < order.size(); ++i) {
+                order[i] = static_cast<int>(i);
+            }
+            RestoreSettings(settings, order, map_renderer,
+                            transport_router);
+            return true;
+        }
 
-        std::unordered_map<size_t, std::string> stops;
+        std::error_code error;
+        const auto file_size = std::filesystem::file_size(file, error);
+        if (error) {
+            return false;
+        }
 
-        source.ParseFromIstream(&in);
+        LoadState state;
+        state.file_size = file_size;
+        const Base header = ReadHeader(file);
+        const bool has_sections = header.stops_offset() > 0 &&
+            header.stops_offset() <= header.distances_offset() &&
+            header.distances_offset() <= header.buses_offset() &&
+            header.buses_offset() <= header.settings_offset() &&
+            header.settings_offset() <= header.base_size() &&
+            header.base_size() <= file_size;
+
+        if (has_sections) {
+            // Stops first, as the rest refers to them, then the
+            // distances on a thread of their own next to the buses.
+            state.has_log = header.base_size() < file_size;
+            state.builder.Reserve(header.stops_count(),
+                header.distances_count(), header.buses_count(),
+                header.route_stops_count());
+            state.stops.reserve(header.stops_count());
+            if (!ReadSection(file, header.stops_offset(),
+                             header.distances_offset(), state)) {
+                return false;
+            }
 
-//        auto& router_stops = transport_router.GetStops();
-//        auto& router_stops_ids = transport_router.GetStopsIds();
-//        router_stops.resize(source.stops_size());
+            SectionBuffer distances;
+            SectionBuffer buses;
+            bool has_distances = false;
+            std::exception_ptr distances_error;
+            std::thread distances_thread([&]() {
+                try {
+                    has_distances = ReadSection(file,
+                        header.distances_offset(), header.buses_offset(),
+                        state, &distances);
+                }
+                catch (...) {
+                    distances_error = std::current_exception();
+                }
+            });
+            bool has_buses = false;
+            try {
+                has_buses = ReadSection(file, header.buses_offset(),
+                                        header.settings_offset(), state,
+                                        &buses);
+            }
+            catch (...) {
+                distances_thread.join();
+                throw;
+            }
+            distances_thread.join();
+            if (distances_error) {
+                std::rethrow_exception(distances_error);
+            }
 
-        for (const auto& stop : source.stops()) {
-            db.AddStop({ stop.name(), stop.latitude(), stop.longitude() });
-            stops[stop.id()] = stop.name();
+            if (!has_distances || !has_buses ||
+                !AddBuffered(distances, state.builder) ||
+                !AddBuffered(buses, state.builder) ||
+                !ReadSection(file, header.settings_offset(),
+                             header.base_size(), state) ||
+                !ReadSection(file, header.base_size(), file_size, state)) {
+                return false;
+            }
+        }
+        else if (!ReadSection(file, 0, file_size, state)) {
+            // A base written before the sections, read in one go.
+            return false;
+        }
 
-//            router_stops[stop.id()] = db.GetStop(stop.name());
-//            router.GetStops();
-//            router.GetStopsIds();
+        // Finalize may reorder the stops, so the components are
+        // matched with them by name.
+        auto& stops = state.stops;
+        auto& settings = state.settings;
+        std::vector<std::string_view> stop_names;
+        const bool has_components = !state.has_log &&
+            settings.has_components() &&
+            settings.components().strong_size() ==
+                static_cast<int>(stops.size());
+        if (has_components) {
+            stop_names.reserve(stops.size());
+            for (const auto stop : stops) {
+                stop_names.push_back(state.builder.GetStopName(stop));
+            }
         }
 
-        std::vector<cat::StopsDistance> stops_distances;
-        stops_distances.reserve(source.road_distances_size());
+        try {
+            db = state.builder.Freeze();
+        }
+        catch (const std::invalid_argument&) {
+            return false;
+        }
 
-        for (const auto& distance : source.road_distances()) {
-            if (stops.count(distance.from_stop_id()) == 0 ||
-                stops.count(distance.to_stop_id()) == 0) {
-                throw std::invalid_argument(
-                    "Invalid Stop in Distances"s);
+        std::vector<int> order;
+        if (has_components) {
+            order.resize(stop_names.size());
+            for (size_t i = 0; i < stop_names.size(); ++i) {
+                order[*db.GetStopId(stop_names[i])] = static_cast<int>(i);
             }
+        }
+        RestoreSettings(settings, order, map_renderer, transport_router);
 
-            cat::StopsDistance s { stops.at(distance.from_stop_id()),
-                                   stops.at(distance.to_stop_id()),
-                                   distance.distance() };
-            
-            stops_distances.emplace_back(std::move(s));
+        return true;
+    }
+
+    // private:
+
+    void Portal::StoreSettings(cat_proto::TransportCatalogueBase& destination,
+                               svg::MapRenderer& map_renderer,
+                               cat::TransportRouter& transport_router) const {
+
+        *destination.mutable_route_map_settings() =
+            ConvertToProto(map_renderer.GetRouteMapSettings());
+
+        *destination.mutable_routing_settings() =
+            ConvertToProto(transport_router.GetRoutingSettings());
+
+        if (!transport_router.GetComponents().IsEmpty()) {
+            *destination.mutable_components() =
+                ConvertToProto(transport_router.GetComponents());
         }
+    }
 
-        db.AddStopDistances(std::move(stops_distances));
+    void Portal::RestoreSettings(
+        const cat_proto::TransportCatalogueBase& source,
+        const std::vector<int>& order,
+        svg::MapRenderer& map_renderer,
+        cat::TransportRouter& transport_router) const {
 
-        for (const auto& bus : source.buses()) {
-            std::vector<std::string> bus_stops;
-            bus_stops.reserve(bus.stop_ids_size());
-            for (const auto& id : bus.stop_ids()) {
-                if (stops.count(id) == 0) {
-                    throw std::invalid_argument(
-                        "Invalid Stop in Buses"s);
-                }
-                bus_stops.emplace_back(stops.at(id));
-            }
-            db.AddBus(bus.name(), bus.is_annular(), std::move(bus_stops));
+        if (!order.empty() && source.has_components() &&
+            source.components().strong_size() ==
+                static_cast<int>(order.size())) {
+            transport_router.GetComponents() =
+                RestoreFromProto(source.components(), order);
         }
 
         if (source.has_route_map_settings()) {
@@ -239,6 +856,170 @@ namespace serialization {
         }
     }
 
+    std::optional<std::vector<geo::Coordinates>> RestoreFromColumns(
+        const cat_proto::StopColumns& columns, ColumnsCursor& cursor) {
+
+        const int count = columns.names_size();
+        if (columns.latitudes_size() != count ||
+            columns.longitudes_size() != count ||
+            columns.exact_latitudes_size() != columns.exact_indices_size() ||
+            columns.exact_longitudes_size() != columns.exact_indices_size()) {
+            return std::nullopt;
+        }
+
+        std::vector<geo::Coordinates> result;
+        result.reserve(count);
+        for (int i = 0; i < count; ++i) {
+            cursor.latitude += columns.latitudes(i);
+            cursor.longitude += columns.longitudes(i);
+            result.push_back({ cursor.latitude / COORDINATE_SCALE,
+                               cursor.longitude / COORDINATE_SCALE });
+        }
+        for (int i = 0; i < columns.exact_indices_size(); ++i) {
+            const auto index = columns.exact_indices(i);
+            if (index < cursor.stop_index ||
+                index - cursor.stop_index >= result.size()) {
+                return std::nullopt;
+            }
+            result[index - cursor.stop_index] = {
+                columns.exact_latitudes(i), columns.exact_longitudes(i) };
+        }
+        cursor.stop_index += count;
+        return result;
+    }
+
+    void ApplyDelta(const cat_proto::BaseDelta& delta_proto,
+                    cat::CatalogueBuilder& builder) {
+
+        for (const auto& stop : delta_proto.stops()) {
+            if (stop.remove()) {
+                builder.RemoveStop(stop.name());
+            }
+            else {
+                builder.AddStop(stop.name(), stop.latitude(),
+                                stop.longitude());
+            }
+        }
+
+        for (const auto& distance : delta_proto.road_distances()) {
+            if (!builder.HasStop(distance.from_stop()) ||
+                !builder.HasStop(distance.to_stop())) {
+                continue;
+            }
+            if (distance.remove()) {
+                builder.RemoveStopDistance(distance.from_stop(),
+                                           distance.to_stop());
+            }
+            else {
+                builder.AddStopDistance(distance.from_stop(),
+                    distance.to_stop(), distance.distance());
+            }
+        }
+
+        for (const auto& bus : delta_proto.buses()) {
+            if (bus.remove()) {
+                builder.RemoveBus(bus.name());
+                continue;
+            }
+            const bool has_stops = std::all_of(bus.stops().begin(),
+                bus.stops().end(), [&builder](const std::string& stop) {
+                    return builder.HasStop(stop);
+                });
+            if (!has_stops) {
+                continue;
+            }
+
+            std::vector<dom::Headway> headways;
+            headways.reserve(bus.headways_size());
+            for (const auto& headway : bus.headways()) {
+                headways.push_back({ headway.start(), headway.end(),
+                                     headway.interval() });
+            }
+            if (!std::all_of(headways.begin(), headways.end(),
+                    [](const dom::Headway& headway) {
+                        return dom::IsValid(headway);
+                    })) {
+                continue;
+            }
+            builder.AddBus(bus.name(), bus.is_annular(), headways);
+            for (const auto& stop : bus.stops()) {
+                builder.AddBusStop(stop);
+            }
+        }
+    }
+
+    cat_proto::StopColumns ConvertToColumns(
+        const std::vector<dom::Stop>& stops, size_t begin, size_t end) {
+
+        auto quantize = [](double value) {
+            return std::llround(value * COORDINATE_SCALE);
+        };
+
+        cat_proto::StopColumns columns;
+        const auto count = static_cast<int>(end - begin);
+        columns.mutable_names()->Reserve(count);
+        columns.mutable_latitudes()->Reserve(count);
+        columns.mutable_longitudes()->Reserve(count);
+
+        // Deltas go on from the last stop of the previous chunk.
+        int64_t previous_lat =
+            begin > 0 ? quantize(stops[begin - 1].latitude) : 0;
+        int64_t previous_lng =
+            begin > 0 ? quantize(stops[begin - 1].longitude) : 0;
+        for (size_t i = begin; i < end; ++i) {
+            const auto& stop = stops[i];
+            columns.add_names(std::string(stop.name));
+            const int64_t lat = quantize(stop.latitude);
+            const int64_t lng = quantize(stop.longitude);
+            columns.add_latitudes(lat - previous_lat);
+            columns.add_longitudes(lng - previous_lng);
+            previous_lat = lat;
+            previous_lng = lng;
+
+            if (lat / COORDINATE_SCALE != stop.latitude ||
+                lng / COORDINATE_SCALE != stop.longitude) {
+                columns.add_exact_indices(static_cast<uint32_t>(i));
+                columns.add_exact_latitudes(stop.latitude);
+                columns.add_exact_longitudes(stop.longitude);
+            }
+        }
+        return columns;
+    }
+
+    std::vector<DistanceValue> SortDistances(
+        const cat::DistanceTable& distances) {
+
+        std::vector<DistanceValue> values;
+        values.reserve(distances.GetSize());
+        distances.ForEach(
+            [&values](dom::StopId from, dom::StopId to, int distance) {
+                values.push_back({ from, to, distance });
+            });
+        std::sort(values.begin(), values.end());
+        return values;
+    }
+
+    cat_proto::DistanceColumns ConvertToColumns(
+        const std::vector<DistanceValue>& distances,
+        size_t begin, size_t end) {
+
+        cat_proto::DistanceColumns columns;
+        const auto count = static_cast<int>(end - begin);
+        columns.mutable_from_stop_ids()->Reserve(count);
+        columns.mutable_to_stop_ids()->Reserve(count);
+        columns.mutable_distances()->Reserve(count);
+        dom::StopId previous_from =
+            begin > 0 ? std::get<0>(distances[begin - 1]) : 0;
+        for (size_t i = begin; i < end; ++i) {
+            const auto& [from, to, distance] = distances[i];
+            columns.add_from_stop_ids(from - previous_from);
+            columns.add_to_stop_ids(static_cast<int32_t>(to - from));
+            columns.add_distances(distance);
+            previous_from = from;
+        }
+        return columns;
+    }
+
     dom::RouteMapSettings RestoreFromProto(
         const cat_proto::RouteMapSettings& route_map_settings_proto) {
 
@@ -324,10 +1105,36 @@ namespace serialization {
             routing_settings_proto.bus_velocity();
         routing_settings.bus_wait_time =
             routing_settings_proto.bus_wait_time();
+        routing_settings.walking_velocity =
+            routing_settings_proto.walking_velocity();
+        routing_settings.walking_radius =
+            routing_settings_proto.walking_radius();
+        routing_settings.transfer_radius =
+            routing_settings_proto.transfer_radius();
 
         return routing_settings;
     }
 
+    graph::Components RestoreFromProto(
+        const cat_proto::Components& components_proto,
+        const std::vector<int>& order) {
+
+        graph::Components components;
+
+        components.strong.reserve(order.size());
+        components.weak.reserve(order.size());
+        for (const int i : order) {
+            components.strong.push_back(components_proto.strong(i));
+            components.weak.push_back(components_proto.weak(i));
+        }
+        components.strong_count = components_proto.strong_count();
+        components.weak_count = components_proto.weak_count();
+        components.closure = { components_proto.closure().begin(),
+                               components_proto.closure().end() };
+
+        return components;
+    }
+
     dom::SerializationSettings&
         Portal::GetSerializationSettings() {
         return serialization_settings_;
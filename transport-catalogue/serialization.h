@@ -2,13 +2,21 @@
 
 #include <transport_catalogue.pb.h>
 
+#include "base_stream.h"
+#include "catalogue_builder.h"
+#include "flat_base.h"
 #include "map_renderer.h"
 #include "transport_catalogue.h"
 #include "transport_router.h"
 
 #include <algorithm>
+#include <cmath>
+#include <exception>
 #include <filesystem>
 #include <fstream>
+#include <optional>
+#include <thread>
+#include <tuple>
 #include <typeinfo>
 
 namespace serialization {
@@ -19,20 +27,48 @@ namespace serialization {
     public:
         Portal() = default;
 
-        void Serialize(const Path& file,
+        // The base is written next to `file` and renamed over it, so
+        // readers never see it half-written. Returns false, leaving
+        // `file` as it was, if the base can not be written.
+        bool Serialize(const Path& file,
                        cat::TransportCatalogue& db,
                        svg::MapRenderer& map_renderer,
                        cat::TransportRouter& transport_router) const;
 
-        void Deserialize(const Path& file,
+        // Reads a base in either format, telling them by the header.
+        // Returns false if the file can not be read as a base.
+        bool Deserialize(const Path& file,
                          cat::TransportCatalogue& db,
                          svg::MapRenderer& map_renderer,
                          cat::TransportRouter& transport_router) const;
 
+        // Appends the changes to the log of the base without parsing
+        // the base. Deserialize replays the log over it. Returns false,
+        // leaving `file` as it was, if the log can not be written;
+        // throws for a flat base, which has no log.
+        bool AppendDelta(const Path& file,
+                         const dom::BaseDelta& delta) const;
+
+        // Whether the log has grown big enough for the base to be
+        // rewritten with it folded in.
+        bool IsLogOversized(const Path& file) const;
+
         dom::SerializationSettings& GetSerializationSettings();
 
     private:
         dom::SerializationSettings serialization_settings_;
+
+        // Settings and components, kept alike in both formats.
+        void StoreSettings(cat_proto::TransportCatalogueBase& destination,
+                           svg::MapRenderer& map_renderer,
+                           cat::TransportRouter& transport_router) const;
+
+        // Components are restored only given `order`, see
+        // RestoreFromProto.
+        void RestoreSettings(const cat_proto::TransportCatalogueBase& source,
+                             const std::vector<int>& order,
+                             svg::MapRenderer& map_renderer,
+                             cat::TransportRouter& transport_router) const;
     };
 
     template<class V>
@@ -50,6 +86,27 @@ namespace serialization {
     cat_proto::RoutingSettings ConvertToProto(
         const dom::RoutingSettings& routing_settings);
 
+    cat_proto::Components ConvertToProto(
+        const graph::Components& components);
+
+    cat_proto::BaseDelta ConvertToProto(const dom::BaseDelta& delta);
+
+    using DistanceValue = std::tuple<dom::StopId, dom::StopId, int>;
+
+    // Distances set explicitly, sorted by the stops.
+    std::vector<DistanceValue> SortDistances(
+        const cat::DistanceTable& distances);
+
+    // A chunk of columns for the stops or the distances in
+    // [begin, end). Chunks written one after another read back as one
+    // message.
+    cat_proto::StopColumns ConvertToColumns(
+        const std::vector<dom::Stop>& stops, size_t begin, size_t end);
+
+    cat_proto::DistanceColumns ConvertToColumns(
+        const std::vector<DistanceValue>& distances,
+        size_t begin, size_t end);
+
 
     dom::RouteMapSettings RestoreFromProto(
         const cat_proto::RouteMapSettings& route_map_settings_proto);
@@ -59,4 +116,29 @@ namespace serialization {
     dom::RoutingSettings RestoreFromProto(
         const cat_proto::RoutingSettings& routing_settings_proto);
 
+    // Running values of the delta-coded columns, carried from one
+    // chunk to the next.
+    struct ColumnsCursor {
+        int64_t latitude = 0;
+        int64_t longitude = 0;
+        uint32_t stop_index = 0;
+        uint32_t from_stop = 0;
+    };
+
+    // Coordinates of the stops of a chunk in the order of the
+    // columns, nullopt if the columns do not match.
+    std::optional<std::vector<geo::Coordinates>> RestoreFromColumns(
+        const cat_proto::StopColumns& columns, ColumnsCursor& cursor);
+
+    // Changes referring to stops the base does not have, and buses
+    // with invalid headways, are skipped, so that a log never makes a
+    // base unreadable.
+    void ApplyDelta(const cat_proto::BaseDelta& delta_proto,
+                    cat::CatalogueBuilder& builder);
+
+    // `order` lists base indices of the stops in the catalogue order.
+    graph::Components RestoreFromProto(
+        const cat_proto::Components& components_proto,
+        const std::vector<int>& order);
+
 } // namespace serialization
\ No newline at end of file
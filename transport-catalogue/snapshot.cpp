@@ -0,0 +1,94 @@
+#include "snapshot.h"
+
+#include <iostream>
+
+namespace serialization {
+
+    using namespace std::literals;
+
+    std::shared_ptr<Snapshot> LoadSnapshot(const Portal& portal,
+                                           const Path& file) {
+        auto snapshot = std::make_shared<Snapshot>();
+        if (!portal.Deserialize(file, snapshot->db,
+                                snapshot->map_renderer,
+                                snapshot->transport_router)) {
+            return nullptr;
+        }
+        snapshot->transport_router.BuildGraph(snapshot->db);
+        snapshot->transport_router.SetRouterIsSet(true);
+        return snapshot;
+    }
+
+    BaseWatcher::BaseWatcher(const Portal& portal, Path file,
+                             std::chrono::milliseconds interval)
+        : portal_(portal)
+        , file_(std::move(file))
+        , interval_(interval)
+    {}
+
+    BaseWatcher::~BaseWatcher() {
+        Stop();
+    }
+
+    bool BaseWatcher::Start() {
+        Reload();
+        if (!GetSnapshot()) {
+            return false;
+        }
+        is_stopped_ = false;
+        thread_ = std::thread([this] { Watch(); });
+        return true;
+    }
+
+    void BaseWatcher::Stop() {
+        {
+            std::lock_guard lock(mutex_);
+            is_stopped_ = true;
+        }
+        stop_signal_.notify_all();
+        if (thread_.joinable()) {
+            thread_.join();
+        }
+    }
+
+    std::shared_ptr<const Snapshot> BaseWatcher::GetSnapshot() const {
+        return std::atomic_load(&snapshot_);
+    }
+
+    // private:
+
+    void BaseWatcher::Reload() {
+        std::error_code error;
+        const auto time = std::filesystem::last_write_time(file_, error);
+        if (error || time == loaded_time_) {
+            return;
+        }
+
+        // A base being written may fail to load; the old snapshot
+        // stays until the next check.
+        std::shared_ptr<Snapshot> snapshot;
+        try {
+            snapshot = LoadSnapshot(portal_, file_);
+        }
+        catch (const std::exception&) {
+        }
+        if (!snapshot) {
+            std::cerr << "Base "sv << file_ << " is not loaded\n"sv;
+            return;
+        }
+        std::atomic_store(&snapshot_,
+            std::shared_ptr<const Snapshot>(std::move(snapshot)));
+        loaded_time_ = time;
+    }
+
+    void BaseWatcher::Watch() {
+        std::unique_lock lock(mutex_);
+        while (!stop_signal_.wait_for(lock, interval_,
+                                      [this] { return is_stopped_; })) {
+            lock.unlock();
+            Reload();
+            lock.lock();
+        }
+    }
+
+} // namespace serialization
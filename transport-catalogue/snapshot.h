@@ -0,0 +1,64 @@
+#pragma once
+
+#include "serialization.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace serialization {
+
+    // Everything needed to answer requests. A snapshot is not changed
+    // after it is loaded: the router is built in advance, but for the
+    // parts built on first use under a lock, and readers only get it
+    // as const.
+    struct Snapshot {
+        cat::TransportCatalogue db;
+        svg::MapRenderer map_renderer;
+        cat::TransportRouter transport_router;
+    };
+
+    // nullptr if the file can not be read as a base.
+    std::shared_ptr<Snapshot> LoadSnapshot(const Portal& portal,
+                                           const Path& file);
+
+    // Keeps the snapshot of the base file up to date. A background
+    // thread checks the modification time of the file and swaps a
+    // freshly loaded snapshot in; readers take the current one with
+    // an atomic load and keep it alive as long as they need it.
+    class BaseWatcher {
+    public:
+        BaseWatcher(const Portal& portal, Path file,
+                    std::chrono::milliseconds interval =
+                        std::chrono::milliseconds(1000));
+        BaseWatcher(const BaseWatcher&) = delete;
+        BaseWatcher& operator=(const BaseWatcher&) = delete;
+        ~BaseWatcher();
+
+        // Loads the base and starts watching it; false, with nothing
+        // started, if the base can not be loaded.
+        bool Start();
+        void Stop();
+
+        std::shared_ptr<const Snapshot> GetSnapshot() const;
+
+    private:
+        const Portal& portal_;
+        const Path file_;
+        const std::chrono::milliseconds interval_;
+
+        std::shared_ptr<const Snapshot> snapshot_;
+        std::filesystem::file_time_type loaded_time_;
+
+        std::mutex mutex_;
+        std::condition_variable stop_signal_;
+        bool is_stopped_ = false;
+        std::thread thread_;
+
+        void Reload();
+        void Watch();
+    };
+
+} // namespace serialization
@@ -0,0 +1,150 @@
+#include "spatial_index.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace geo {
+
+    const double METERS_PER_DEGREE = 111194.92664;  // 6371 km * PI / 180
+    const double RADIAN_PER_DEGREE = 0.017453292519;  // PI / 180
+    const double MAX_LATITUDE = 89.0;
+    const double LONGITUDE_MARGIN = 1.01;
+
+    void SpatialIndex::Build(const std::vector<Coordinates>& points,
+                             double cell_size) {
+        Clear();
+        if (points.empty() || !(cell_size > 0)) {
+            return;
+        }
+
+        points_.reserve(points.size());
+        for (const auto& point : points) {
+            points_.push_back(Prepare(point));
+        }
+        min_lat_ = points.front().lat;
+        min_lng_ = points.front().lng;
+        double max_lat = min_lat_;
+        double max_lng = min_lng_;
+        for (const auto& point : points) {
+            min_lat_ = std::min(min_lat_, point.lat);
+            min_lng_ = std::min(min_lng_, point.lng);
+            max_lat = std::max(max_lat, point.lat);
+            max_lng = std::max(max_lng, point.lng);
+            max_abs_lat_ = std::max(max_abs_lat_, std::abs(point.lat));
+        }
+        max_abs_lat_ = std::min(max_abs_lat_, MAX_LATITUDE);
+
+        // A degree of longitude is the shortest at the highest
+        // latitude, so cells are sized by it.
+        lat_step_ = cell_size / METERS_PER_DEGREE;
+        lng_step_ = cell_size / (METERS_PER_DEGREE *
+            std::cos(max_abs_lat_ * RADIAN_PER_DEGREE));
+        max_row_ = Row(max_lat);
+        max_column_ = Column(max_lng);
+
+        cells_.reserve(points.size());
+        for (size_t i = 0; i < points.size(); ++i) {
+            cells_.push_back({ CellKey(Row(points[i].lat),
+                                       Column(points[i].lng)),
+                               static_cast<uint32_t>(i) });
+        }
+        std::sort(cells_.begin(), cells_.end(),
+            [](const Cell& lhs, const Cell& rhs) {
+                return lhs.key < rhs.key ||
+                    (lhs.key == rhs.key && lhs.point < rhs.point);
+            });
+    }
+
+    std::vector<std::pair<size_t, double>>
+    SpatialIndex::FindInRadius(Coordinates center, double radius) const {
+
+        std::vector<std::pair<size_t, double>> result;
+        if (cells_.empty() || radius < 0) {
+            return result;
+        }
+
+        const auto prepared_center = Prepare(center);
+        auto check_point = [&](size_t index) {
+            const double distance =
+                ComputeDistance(prepared_center, points_[index]);
+            if (distance <= radius) {
+                result.push_back({ index, distance });
+            }
+        };
+
+        const double lat_delta = radius / METERS_PER_DEGREE;
+        const double abs_lat = std::min(MAX_LATITUDE,
+            std::max(max_abs_lat_, std::abs(center.lat) + lat_delta));
+        // A great circle runs a bit shorter than a parallel, hence
+        // the margin.
+        const double lng_delta = LONGITUDE_MARGIN * radius /
+            (METERS_PER_DEGREE * std::cos(abs_lat * RADIAN_PER_DEGREE));
+
+        const int64_t row_from =
+            std::max<int64_t>(0, Row(center.lat - lat_delta));
+        const int64_t row_to =
+            std::min(max_row_, Row(center.lat + lat_delta));
+        const int64_t column_from =
+            std::max<int64_t>(0, Column(center.lng - lng_delta));
+        const int64_t column_to =
+            std::min(max_column_, Column(center.lng + lng_delta));
+        if (row_from > row_to || column_from > column_to) {
+            return result;
+        }
+
+        // A wide query is cheaper as a plain scan.
+        const double cells_count =
+            static_cast<double>(row_to - row_from + 1) *
+            static_cast<double>(column_to - column_from + 1);
+        if (cells_count > static_cast<double>(cells_.size())) {
+            for (size_t i = 0; i < points_.size(); ++i) {
+                check_point(i);
+            }
+            return result;
+        }
+
+        for (int64_t row = row_from; row <= row_to; ++row) {
+            auto it = std::lower_bound(cells_.begin(), cells_.end(),
+                CellKey(row, column_from),
+                [](const Cell& cell, uint64_t key) {
+                    return cell.key < key;
+                });
+            const uint64_t last_key = CellKey(row, column_to);
+            for (; it != cells_.end() && it->key <= last_key; ++it) {
+                check_point(it->point);
+            }
+        }
+
+        return result;
+    }
+
+    size_t SpatialIndex::GetSize() const {
+        return points_.size();
+    }
+
+    void SpatialIndex::Clear() {
+        cells_.clear();
+        points_.clear();
+        min_lat_ = min_lng_ = max_abs_lat_ = 0.0;
+        lat_step_ = lng_step_ = 0.0;
+        max_row_ = max_column_ = 0;
+    }
+
+    // private:
+
+    int64_t SpatialIndex::Row(double lat) const {
+        return static_cast<int64_t>(
+            std::floor((lat - min_lat_) / lat_step_));
+    }
+
+    int64_t SpatialIndex::Column(double lng) const {
+        return static_cast<int64_t>(
+            std::floor((lng - min_lng_) / lng_step_));
+    }
+
+    uint64_t SpatialIndex::CellKey(int64_t row, int64_t column) {
+        return (static_cast<uint64_t>(row) << 32) |
+            static_cast<uint64_t>(column);
+    }
+
+} // namespace geo
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "geo.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace geo {
+
+    // Uniform grid over points for radius queries. Cells are at least
+    // `cell_size` meters wide in a local equirectangular projection;
+    // only non-empty cells are kept, as points sorted by cell keys.
+    class SpatialIndex {
+    public:
+        SpatialIndex() = default;
+
+        void Build(const std::vector<Coordinates>& points,
+                   double cell_size);
+
+        // Indices of the points within `radius` meters of `center`
+        // together with the distances to them.
+        std::vector<std::pair<size_t, double>>
+        FindInRadius(Coordinates center, double radius) const;
+
+        size_t GetSize() const;
+
+        void Clear();
+
+    private:
+        struct Cell {
+            uint64_t key = 0;
+            uint32_t point = 0;
+        };
+
+        double min_lat_ = 0.0;
+        double min_lng_ = 0.0;
+        double max_abs_lat_ = 0.0;
+        double lat_step_ = 0.0;
+        double lng_step_ = 0.0;
+        int64_t max_row_ = 0;
+        int64_t max_column_ = 0;
+        std::vector<Cell> cells_;
+        std::vector<PreparedCoordinates> points_;
+
+        int64_t Row(double lat) const;
+        int64_t Column(double lng) const;
+        static uint64_t CellKey(int64_t row, int64_t column);
+    };
+
+} // namespace geo
@@ -0,0 +1,39 @@
+#include "string_pool.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace cat {
+
+    std::string_view StringPool::Store(std::string_view value) {
+        if (value.empty()) {
+            return {};
+        }
+
+        // Move on to the next chunk which has room for the value,
+        // allocating one if none is left.
+        while (current_ < chunks_.size() &&
+               used_ + value.size() > chunks_[current_].size) {
+            ++current_;
+            used_ = 0;
+        }
+        if (current_ == chunks_.size()) {
+            Chunk chunk;
+            chunk.size = std::max(CHUNK_SIZE, value.size());
+            chunk.data = std::make_unique<char[]>(chunk.size);
+            chunks_.push_back(std::move(chunk));
+            used_ = 0;
+        }
+
+        char* data = chunks_[current_].data.get() + used_;
+        std::memcpy(data, value.data(), value.size());
+        used_ += value.size();
+        return { data, value.size() };
+    }
+
+    void StringPool::Clear() {
+        current_ = 0;
+        used_ = 0;
+    }
+
+} // namespace cat
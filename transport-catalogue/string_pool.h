@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+namespace cat {
+
+    // Keeps strings one after another in large chunks, so that
+    // storing a name costs no allocation of its own and the views
+    // returned stay valid until Clear().
+    class StringPool {
+    public:
+        StringPool() = default;
+
+        std::string_view Store(std::string_view value);
+
+        // Forgets the strings but keeps the chunks for reuse.
+        void Clear();
+
+    private:
+        static constexpr size_t CHUNK_SIZE = 64 * 1024;
+
+        struct Chunk {
+            std::unique_ptr<char[]> data;
+            size_t size = 0;
+        };
+
+        std::vector<Chunk> chunks_;
+        size_t current_ = 0;
+        size_t used_ = 0;
+    };
+
+} // namespace cat
@@ -1,183 +1,394 @@
 #include "transport_catalogue.h"
 
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <iterator>
+#include <thread>
+#include <tuple>
+
 namespace cat {
 
     using namespace std::string_literals;
 
-    const size_t PRIME_NUMBER = 37;
+    const uint32_t HILBERT_ORDER = 16;
+    const double STOPS_INDEX_CELL_SIZE = 500.0;
 
     namespace detail {
-        bool Buscomp::operator()
-            (const dom::Bus* left, const dom::Bus* right) const {
-            return left->name < right->name;
+        // Distance of the cell (x, y) along the Hilbert curve filling
+        // the square of 2^HILBERT_ORDER cells per side.
+        uint64_t HilbertIndex(uint32_t x, uint32_t y) {
+            const uint32_t side = 1u << HILBERT_ORDER;
+            uint64_t index = 0;
+            for (uint32_t s = side / 2; s > 0; s /= 2) {
+                const uint32_t rx = (x & s) > 0 ? 1 : 0;
+                const uint32_t ry = (y & s) > 0 ? 1 : 0;
+                index += static_cast<uint64_t>(s) * s * ((3 * rx) ^ ry);
+                if (ry == 0) {
+                    if (rx == 1) {
+                        x = side - 1 - x;
+                        y = side - 1 - y;
+                    }
+                    std::swap(x, y);
+                }
+            }
+            return index;
+        }
+
+        int CountTrailingZeros(uint64_t value) {
+#if defined(__GNUC__)
+            return __builtin_ctzll(value);
+#else
+            int count = 0;
+            while ((value & 1) == 0) {
+                value >>= 1;
+                ++count;
+            }
+            return count;
+#endif
         }
 
-        size_t TwoStopsHasher::operator()
-            (const std::pair<dom::Stop*, dom::Stop*> stops) const {
-            return reinterpret_cast<size_t>(stops.first) +
-                reinterpret_cast<size_t>(stops.second) *
-                PRIME_NUMBER;
+        // Lowercases Latin and Cyrillic letters of a UTF-8 string,
+        // leaving all other bytes as they are.
+        std::string FoldCase(std::string_view text) {
+            std::string result(text);
+            for (size_t i = 0; i < result.size(); ++i) {
+                auto byte = static_cast<unsigned char>(result[i]);
+                if (byte >= 'A' && byte <= 'Z') {
+                    result[i] = static_cast<char>(byte - 'A' + 'a');
+                    continue;
+                }
+                if (byte != 0xD0 || i + 1 == result.size()) {
+                    continue;
+                }
+                auto next = static_cast<unsigned char>(result[i + 1]);
+                if (next >= 0x90 && next <= 0x9F) {
+                    // А..П -> а..п
+                    result[i + 1] = static_cast<char>(next + 0x20);
+                }
+                else if (next >= 0xA0 && next <= 0xAF) {
+                    // Р..Я -> р..я
+                    result[i] = static_cast<char>(0xD1);
+                    result[i + 1] = static_cast<char>(next - 0x20);
+                }
+                else if (next >= 0x80 && next <= 0x8F) {
+                    // Ѐ..Џ, Ё among them -> ѐ..џ
+                    result[i] = static_cast<char>(0xD1);
+                    result[i + 1] = static_cast<char>(next + 0x10);
+                }
+                ++i;
+            }
+            return result;
         }
     }
 
     // public:
 
-    void TransportCatalogue::AddStop(
-        const std::string_view stop_name,
-        double latitude, double longitude) {
-        dom::Stop stop;
-        stop.name = std::string(stop_name);
-        stop.latitude = latitude;
-        stop.longitude = longitude;
-        AddStop(std::move(stop));
+    std::optional<dom::StopId> TransportCatalogue::GetStopId(
+        const std::string_view stop_name) const {
+        const auto it = stops_map_.find(stop_name);
+        if (it == stops_map_.end()) {
+            return std::nullopt;
+        }
+        return it->second;
+    }
+
+    std::optional<dom::BusId> TransportCatalogue::GetBusId(
+        const std::string_view bus_name) const {
+        const auto it = buses_map_.find(bus_name);
+        if (it == buses_map_.end()) {
+            return std::nullopt;
+        }
+        return it->second;
+    }
+
+    const dom::Stop* TransportCatalogue::GetStop(
+        const std::string_view stop_name) const {
+        const auto id = GetStopId(stop_name);
+        return id ? &stops_[*id] : nullptr;
+    }
+
+    const dom::Bus* TransportCatalogue::GetBus(
+        const std::string_view bus_name) const {
+        const auto id = GetBusId(bus_name);
+        return id ? &buses_[*id] : nullptr;
+    }
+
+    const dom::Stop& TransportCatalogue::GetStop(
+        dom::StopId stop_id) const {
+        return stops_[stop_id];
     }
 
-    void TransportCatalogue::AddStop(const dom::Stop& stop) {
-        stops_.push_back(stop);
-        stops_map_[stops_.back().name] = &stops_.back();
+    const dom::Bus& TransportCatalogue::GetBus(
+        dom::BusId bus_id) const {
+        return buses_[bus_id];
     }
 
-    void TransportCatalogue::AddStopDistances(
-        const std::string_view stop_name,
-        const std::vector<std::pair<std::string, int>>&
-        distances) {
+    int TransportCatalogue::DistanceBetweenStops(
+        const std::string_view stop_name1,
+        const std::string_view stop_name2) const {
 
-        if (stops_map_.count(stop_name) == 0) {
+        const auto stop1 = GetStopId(stop_name1);
+        const auto stop2 = GetStopId(stop_name2);
+        if (!stop1 || !stop2) {
             throw std::invalid_argument(
                 "Invalid Stop in Distances"s);
         }
 
-        const auto& from_stop = stops_map_.at(stop_name);
-        for (const auto& value : distances) {
-            if (stops_map_.count(value.first) == 0) {
-                throw std::invalid_argument(
-                    "Invalid Stop in Distances"s);
-            }
-            distances_[{from_stop, stops_map_.at(value.first)}] =
-                value.second;
-        }
+        return DistanceBetweenStops(*stop1, *stop2);
     }
 
-    void TransportCatalogue::AddStopDistances(
-        const std::vector<StopsDistance>& stops_distances) {
+    int TransportCatalogue::DistanceBetweenStops(
+        dom::StopId stop1, dom::StopId stop2) const {
 
-        for (const auto& value : stops_distances) {
-            if (stops_map_.count(value.from_stop) == 0 ||
-                stops_map_.count(value.to_stop) == 0) {
-                throw std::invalid_argument(
-                    "Invalid Stop in Distances"s);
-            }
-            distances_[{ stops_map_.at(value.from_stop),
-                stops_map_.at(value.to_stop) }] =
-                value.distance;
+        return distances_.Get(stop1, stop2);
+    }
+
+    double TransportCatalogue::RouteGeoLength(
+        const std::string_view bus_name) const {
+
+        const auto bus = GetBus(bus_name);
+        return bus != nullptr ? RouteGeoLength(*bus) : 0.0;
+    }
+
+    int TransportCatalogue::RouteLength(
+        const std::string_view bus_name) const {
+
+        const auto bus = GetBus(bus_name);
+        return bus != nullptr ? RouteLength(*bus) : 0;
+    }
+
+    const dom::BusInfo TransportCatalogue::GetBusInfo(
+        std::string_view bus_name) const {
+
+        dom::BusInfo bus_info;
+        bus_info.name = std::string(bus_name);
+        if (const auto bus = GetBus(bus_name)) {
+            const auto stats = bus->stats
+                ? *bus->stats : ComputeBusStats(*bus);
+            bus_info.route_stops = stats.route_stops;
+            bus_info.unique_stops = stats.unique_stops;
+            bus_info.length = stats.length;
+            bus_info.curvature = stats.curvature;
         }
+
+        return bus_info;
     }
 
-    void TransportCatalogue::AddBus(
-        const std::string_view bus_name,
-        bool is_annular,
-        const std::vector<std::string>& stop_names) {
+    const dom::StopInfo TransportCatalogue::GetStopInfo(
+        std::string_view stop_name) const {
 
-        dom::Bus bus;
-        for (const auto& stop_name : stop_names) {
-            if (stops_map_.count(stop_name) == 0) {
-                throw std::invalid_argument(
-                    "Invalid Stop in Bus"s);
-            }
-            bus.stops.push_back(stops_map_.at(stop_name));
+        dom::StopInfo stop_info;
+        stop_info.name = stop_name;
+        const auto id = GetStopId(stop_name);
+        stop_info.exists = id.has_value();
+        if (stop_info.exists) {
+            stop_info.buses = GetStopBuses(*id);
         }
-        bus.name = std::string(bus_name);
-        bus.is_annular = is_annular;
 
-        buses_.push_back(std::move(bus));
-        buses_map_[buses_.back().name] = &buses_.back();
-        InsertBusesToStop(&buses_.back());
+        return stop_info;
     }
 
-    const dom::Stop* TransportCatalogue::GetStop(
-        const std::string_view stop_name) const {
-        return (stops_map_.count(stop_name) > 0) ?
-            stops_map_.at(stop_name) : nullptr;
+    const std::unordered_map<std::string_view, dom::StopId>&
+        TransportCatalogue::GetStops() const {
+        return stops_map_;
     }
 
-    const dom::Bus* TransportCatalogue::GetBus(
-        const std::string_view bus_name) const {
-        return (buses_map_.count(bus_name) > 0) ?
-            buses_map_.at(bus_name) : nullptr;
+    const std::vector<dom::Stop>&
+        TransportCatalogue::GetStopsList() const {
+        return stops_;
     }
 
-    int TransportCatalogue::DistanceBetweenStops(
-        const std::string_view stop_name1,
-        const std::string_view stop_name2) const {
+    const std::unordered_map<std::string_view, dom::BusId>&
+        TransportCatalogue::GetBuses() const {
+        return buses_map_;
+    }
 
-        if (stops_map_.count(stop_name1) == 0 ||
-            stops_map_.count(stop_name2) == 0) {
-            throw std::invalid_argument(
-                "Invalid Stop in Distances"s);
+    const std::vector<dom::Bus>&
+        TransportCatalogue::GetBusesList() const {
+        return buses_;
+    }
+
+    ranges::Range<const dom::BusId*>
+        TransportCatalogue::GetStopBuses(dom::StopId stop_id) const {
+        const auto& offsets = views_.stop_buses_offsets;
+        if (stop_id + 1 >= offsets.size()) {
+            return { nullptr, nullptr };
         }
+        const dom::BusId* buses = views_.stop_buses.begin();
+        return { buses + offsets[stop_id], buses + offsets[stop_id + 1] };
+    }
 
-        return DistanceBetweenStops(stops_map_.at(stop_name1),
-            stops_map_.at(stop_name2));
+    const DistanceTable&
+        TransportCatalogue::GetDistances() const {
+        return distances_;
     }
 
-    int TransportCatalogue::DistanceBetweenStops(
-        dom::Stop* stop1, dom::Stop* stop2) const {
+    std::vector<std::pair<dom::StopId, double>>
+        TransportCatalogue::NearbyStops(double latitude,
+            double longitude, double radius, size_t limit) const {
 
-        auto pair_stop = std::pair(stop1, stop2);
-        if (distances_.count(pair_stop) > 0) {
-            return distances_.at(pair_stop);
-        }
+        const auto found = stops_index_.FindInRadius(
+            { latitude, longitude }, radius);
 
-        pair_stop = std::pair(stop2, stop1);
-        if (distances_.count(pair_stop) > 0) {
-            return distances_.at(pair_stop);
+        std::vector<std::pair<dom::StopId, double>> result;
+        result.reserve(found.size());
+        for (const auto& [stop, distance] : found) {
+            result.push_back({ static_cast<dom::StopId>(stop),
+                               distance });
         }
 
-        return 0;
+        auto by_distance = [](const auto& lhs, const auto& rhs) {
+            return std::tie(lhs.second, lhs.first) <
+                   std::tie(rhs.second, rhs.first);
+        };
+        if (limit < result.size()) {
+            std::partial_sort(result.begin(), result.begin() + limit,
+                              result.end(), by_distance);
+            result.resize(limit);
+        }
+        else {
+            std::sort(result.begin(), result.end(), by_distance);
+        }
+        return result;
     }
 
-    double TransportCatalogue::RouteGeoLength(
-        const std::string_view bus_name) const {
+    std::vector<dom::DirectBus> TransportCatalogue::DirectBuses(
+        dom::StopId from_stop, dom::StopId to_stop) const {
 
-        if (buses_map_.count(bus_name) == 0) {
-            return 0.0;
+        std::vector<dom::DirectBus> result;
+        if (from_stop == to_stop || stop_bus_words_ == 0) {
+            return result;
         }
 
-        double result = 0.0;
-        double prev_latitude;
-        double prev_longitude;
-        bool is_first_stop = true;
-        for (const auto& stop : buses_map_.at(bus_name)->stops) {
-            if (is_first_stop) {
-                prev_latitude = stop->latitude;
-                prev_longitude = stop->longitude;
-                is_first_stop = false;
-                continue;
+        const uint64_t* from_row =
+            views_.stop_bus_bits.begin() + from_stop * stop_bus_words_;
+        const uint64_t* to_row =
+            views_.stop_bus_bits.begin() + to_stop * stop_bus_words_;
+        for (size_t word = 0; word < stop_bus_words_; ++word) {
+            uint64_t bits = from_row[word] & to_row[word];
+            while (bits != 0) {
+                const size_t rank =
+                    word * 64 + detail::CountTrailingZeros(bits);
+                bits &= bits - 1;
+                const auto bus = views_.buses_by_name[rank];
+                if (const auto span = SpanCount(bus, from_stop, to_stop)) {
+                    result.push_back({ bus, *span });
+                }
             }
-            result += geo::ComputeDistance(
-                { prev_latitude, prev_longitude },
-                { stop->latitude, stop->longitude });
-            prev_latitude = stop->latitude;
-            prev_longitude = stop->longitude;
         }
+        return result;
+    }
 
-        return buses_map_.at(bus_name)->is_annular
-            ? result : result * 2;
+    std::vector<dom::StopId> TransportCatalogue::SearchStops(
+        std::string_view prefix, size_t limit) const {
+
+        const auto key = detail::FoldCase(prefix);
+        const auto& search = views_.stops_search;
+        auto name_of = [this](const SearchEntry& entry) {
+            return std::string_view(
+                views_.search_names.begin() + entry.name_offset,
+                entry.name_size);
+        };
+        auto it = std::lower_bound(search.begin(), search.end(),
+            std::string_view(key),
+            [&name_of](const SearchEntry& entry, std::string_view value) {
+                return name_of(entry) < value;
+            });
+
+        std::vector<dom::StopId> result;
+        for (; it != search.end() && result.size() < limit
+               && name_of(*it).substr(0, key.size()) == key; ++it) {
+            result.push_back(it->stop);
+        }
+        return result;
     }
 
-    int TransportCatalogue::RouteLength(
-        const std::string_view bus_name) const {
+    void TransportCatalogue::Clear() {
+        views_ = Views{};
+        stops_search_.clear();
+        search_names_.clear();
+        stop_bus_words_ = 0;
+        stop_bus_bits_.clear();
+        buses_by_name_.clear();
+        route_positions_.clear();
+        stop_buses_offsets_.clear();
+        stop_buses_.clear();
+        distances_.Clear();
+        stops_index_.Clear();
+
+        route_offsets_.resize(1);
+        route_stops_.clear();
+
+        buses_map_.clear();
+        buses_.clear();
 
-        if (buses_map_.count(bus_name) == 0) {
-            return 0;
+        stops_map_.clear();
+        stops_.clear();
+
+        names_.Clear();
+        storage_.reset();
+    }
+
+    // private:
+
+    void TransportCatalogue::Finalize() {
+        BindRouteStops();
+
+        buses_map_.clear();
+        buses_map_.reserve(buses_.size());
+        for (const auto& bus : buses_) {
+            buses_map_[bus.name] = bus.id;
         }
 
+        OrderStopsAlongHilbertCurve();
+        distances_.ResolveReverse();
+
+        // Each index below is built from the stops, the routes and the
+        // distances only and fills in its own members, so they are
+        // built side by side while the statistics are computed.
+        std::vector<std::thread> threads;
+        threads.emplace_back([this]() { BuildStopBuses(); });
+        threads.emplace_back([this]() { BuildDirectIndex(); });
+        threads.emplace_back([this]() {
+            BuildStopsIndex();
+            BuildStopsSearch();
+        });
+        ComputeMissingStats();
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        BindViews();
+    }
+
+    double TransportCatalogue::RouteGeoLength(
+        const dom::Bus& bus) const {
+
+        const size_t count = bus.stops.size();
+        std::vector<double> lat(count);
+        std::vector<double> lng(count);
+        std::vector<double> sin_lat(count);
+        std::vector<double> cos_lat(count);
+        for (size_t i = 0; i < count; ++i) {
+            const auto& stop = stops_[bus.stops[i]];
+            lat[i] = stop.latitude;
+            lng[i] = stop.longitude;
+            sin_lat[i] = stop.sin_lat;
+            cos_lat[i] = stop.cos_lat;
+        }
+        const double result = geo::ComputeLength(lat.data(), lng.data(),
+            sin_lat.data(), cos_lat.data(), count);
+
+        return bus.is_annular ? result : result * 2;
+    }
+
+    int TransportCatalogue::RouteLength(const dom::Bus& bus) const {
+
         int result = 0;
-        const auto& bus = buses_map_.at(bus_name);
-        bool is_annular = bus->is_annular;
-        dom::Stop* from_stop = nullptr;
+        bool is_annular = bus.is_annular;
+        dom::StopId from_stop = 0;
         bool is_first_stop = true;
-        for (const auto& stop : bus->stops) {
+        for (const auto stop : bus.stops) {
             if (is_first_stop) {
                 from_stop = stop;
                 is_first_stop = false;
@@ -194,93 +405,284 @@ namespace cat {
         return result;
     }
 
-    const dom::BusInfo TransportCatalogue::GetBusInfo(
-        std::string_view bus_name) const {
+    dom::BusStats TransportCatalogue::ComputeBusStats(
+        const dom::Bus& bus) const {
 
-        dom::BusInfo bus_info;
-        bus_info.name = std::string(bus_name);
-        if (buses_map_.count(bus_name) > 0) {
-            const auto& bus = buses_map_.at(bus_name);
-            const auto& stops = bus->stops;
-            bus_info.route_stops = bus->is_annular
-                ? static_cast<int>(stops.size())
-                : static_cast<int>(stops.size()) * 2 - 1;
-
-            std::unordered_set<dom::Stop*> tmp_stops =
-            { stops.begin(), stops.end() };
-            bus_info.unique_stops =
-                static_cast<int>(tmp_stops.size());
-            bus_info.length = RouteLength(bus_name);
-            bus_info.curvature =
-                bus_info.length / RouteGeoLength(bus_name);
+        dom::BusStats stats;
+        const auto& stops = bus.stops;
+        stats.route_stops = bus.is_annular
+            ? static_cast<int>(stops.size())
+            : static_cast<int>(stops.size()) * 2 - 1;
+
+        std::unordered_set<dom::StopId> tmp_stops =
+        { stops.begin(), stops.end() };
+        stats.unique_stops = static_cast<int>(tmp_stops.size());
+        stats.length = RouteLength(bus);
+        stats.curvature = stats.length / RouteGeoLength(bus);
+
+        return stats;
+    }
+
+    void TransportCatalogue::ComputeMissingStats() {
+        // Buses are handed out to the threads one by one; computing
+        // the statistics of one only reads the catalogue.
+        std::atomic<size_t> next_bus{ 0 };
+        auto work = [this, &next_bus]() {
+            for (size_t bus = next_bus++; bus < buses_.size();
+                 bus = next_bus++) {
+                if (!buses_[bus].stats) {
+                    buses_[bus].stats = ComputeBusStats(buses_[bus]);
+                }
+            }
+        };
+
+        const size_t threads_count = std::min<size_t>(buses_.size(),
+            std::max(1u, std::thread::hardware_concurrency()));
+        std::vector<std::thread> threads;
+        for (size_t i = 1; i < threads_count; ++i) {
+            threads.emplace_back(work);
         }
+        work();
+        for (auto& thread : threads) {
+            thread.join();
+        }
+    }
 
-        return bus_info;
+    void TransportCatalogue::BindViews() {
+        auto view = [](const auto& values) {
+            return ranges::Range{ values.data(),
+                                  values.data() + values.size() };
+        };
+        views_.route_stops = view(route_stops_);
+        views_.route_offsets = view(route_offsets_);
+        views_.stop_buses_offsets = view(stop_buses_offsets_);
+        views_.stop_buses = view(stop_buses_);
+        views_.stop_bus_bits = view(stop_bus_bits_);
+        views_.buses_by_name = view(buses_by_name_);
+        views_.route_positions = view(route_positions_);
+        views_.stops_search = view(stops_search_);
+        views_.search_names = view(search_names_);
     }
 
-    const dom::StopInfo TransportCatalogue::GetStopInfo(
-        std::string_view stop_name) const {
+    void TransportCatalogue::BindRouteStops() {
+        const dom::StopId* data = route_stops_.data();
+        for (auto& bus : buses_) {
+            bus.stops = { data + route_offsets_[bus.id],
+                          data + route_offsets_[bus.id + 1] };
+        }
+    }
 
-        dom::StopInfo stop_info;
-        stop_info.name = std::string(stop_name);
-        stop_info.exists = (stops_map_.count(stop_name) > 0);
-        if (stop_info.exists) {
-            dom::Stop* stop = stops_map_.at(stop_name);
-            if (stop_buses_map_.count(stop) > 0) {
-                const auto& buses_at_stop =
-                    stop_buses_map_.at(stop);
-                stop_info.buses = { buses_at_stop.begin(),
-                                    buses_at_stop.end() };
+    void TransportCatalogue::BuildStopBuses() {
+        std::vector<dom::BusId> buses(buses_.size());
+        for (dom::BusId id = 0; id < buses.size(); ++id) {
+            buses[id] = id;
+        }
+        std::sort(buses.begin(), buses.end(),
+            [this](dom::BusId lhs, dom::BusId rhs) {
+                return buses_[lhs].name < buses_[rhs].name;
+            });
+
+        // A bus may pass a stop several times, `last_bus` keeps it
+        // from being counted twice. Buses are taken by name, so every
+        // stop gets its buses sorted.
+        const auto no_bus = static_cast<dom::BusId>(buses_.size());
+        std::vector<dom::BusId> last_bus(stops_.size(), no_bus);
+        stop_buses_offsets_.assign(stops_.size() + 1, 0);
+        for (const auto bus : buses) {
+            for (const auto stop : buses_[bus].stops) {
+                if (last_bus[stop] != bus) {
+                    last_bus[stop] = bus;
+                    ++stop_buses_offsets_[stop + 1];
+                }
             }
         }
+        for (size_t i = 1; i < stop_buses_offsets_.size(); ++i) {
+            stop_buses_offsets_[i] += stop_buses_offsets_[i - 1];
+        }
 
-        return stop_info;
+        std::vector<uint32_t> positions(stop_buses_offsets_.begin(),
+                                        stop_buses_offsets_.end() - 1);
+        std::fill(last_bus.begin(), last_bus.end(), no_bus);
+        stop_buses_.resize(stop_buses_offsets_.back());
+        for (const auto bus : buses) {
+            for (const auto stop : buses_[bus].stops) {
+                if (last_bus[stop] != bus) {
+                    last_bus[stop] = bus;
+                    stop_buses_[positions[stop]++] = bus;
+                }
+            }
+        }
     }
 
-    const std::unordered_map<std::string_view, dom::Stop*>&
-        TransportCatalogue::GetStops() const {
-        return stops_map_;
+    void TransportCatalogue::BuildDirectIndex() {
+        buses_by_name_.resize(buses_.size());
+        for (dom::BusId id = 0; id < buses_.size(); ++id) {
+            buses_by_name_[id] = id;
+        }
+        std::sort(buses_by_name_.begin(), buses_by_name_.end(),
+            [this](dom::BusId lhs, dom::BusId rhs) {
+                return buses_[lhs].name < buses_[rhs].name;
+            });
+
+        stop_bus_words_ = (buses_.size() + 63) / 64;
+        stop_bus_bits_.assign(stops_.size() * stop_bus_words_, 0);
+        for (size_t rank = 0; rank < buses_by_name_.size(); ++rank) {
+            const uint64_t bit = uint64_t{ 1 } << (rank % 64);
+            for (const auto stop : buses_[buses_by_name_[rank]].stops) {
+                stop_bus_bits_[stop * stop_bus_words_ + rank / 64] |= bit;
+            }
+        }
+
+        route_positions_.resize(route_stops_.size());
+        for (size_t bus = 0; bus < buses_.size(); ++bus) {
+            const auto begin = route_offsets_[bus];
+            const auto end = route_offsets_[bus + 1];
+            for (auto i = begin; i < end; ++i) {
+                route_positions_[i] = { route_stops_[i], i - begin };
+            }
+            std::sort(route_positions_.begin() + begin,
+                      route_positions_.begin() + end,
+                [](const RoutePosition& lhs, const RoutePosition& rhs) {
+                    return std::tie(lhs.stop, lhs.position) <
+                           std::tie(rhs.stop, rhs.position);
+                });
+        }
     }
 
-    const std::unordered_map<std::string_view, dom::Bus*>&
-        TransportCatalogue::GetBuses() const {
-        return buses_map_;
+    std::optional<int> TransportCatalogue::SpanCount(dom::BusId bus_id,
+        dom::StopId from_stop, dom::StopId to_stop) const {
+
+        const auto begin = views_.route_positions.begin() +
+            views_.route_offsets[bus_id];
+        const auto end = views_.route_positions.begin() +
+            views_.route_offsets[bus_id + 1];
+        auto positions = [begin, end](dom::StopId stop) {
+            return std::equal_range(begin, end, RoutePosition{ stop, 0 },
+                [](const RoutePosition& lhs, const RoutePosition& rhs) {
+                    return lhs.stop < rhs.stop;
+                });
+        };
+        const auto [from_begin, from_end] = positions(from_stop);
+        const auto [to_begin, to_end] = positions(to_stop);
+        const bool is_annular = buses_[bus_id].is_annular;
+
+        // Positions of both stops are sorted: for every position of
+        // the first one the nearest positions of the second one are
+        // next to each other.
+        std::optional<int> result;
+        for (auto from = from_begin; from != from_end; ++from) {
+            const auto to = std::upper_bound(to_begin, to_end,
+                from->position,
+                [](uint32_t position, const RoutePosition& item) {
+                    return position < item.position;
+                });
+            if (to != to_end) {
+                const int span =
+                    static_cast<int>(to->position - from->position);
+                result = result ? std::min(*result, span) : span;
+            }
+            if (!is_annular && to != to_begin) {
+                const int span = static_cast<int>(
+                    from->position - std::prev(to)->position);
+                result = result ? std::min(*result, span) : span;
+            }
+        }
+        return result;
     }
 
-    const std::unordered_map<dom::Stop*, SetBus>&
-        TransportCatalogue::GetStopBuses() const {
-        return stop_buses_map_;
+    void TransportCatalogue::BuildStopsIndex() {
+        std::vector<geo::Coordinates> stops_coordinates;
+        stops_coordinates.reserve(stops_.size());
+        for (const auto& stop : stops_) {
+            stops_coordinates.push_back({ stop.latitude, stop.longitude });
+        }
+        stops_index_.Build(stops_coordinates, STOPS_INDEX_CELL_SIZE);
     }
 
-    const MapStopsDistance&
-        TransportCatalogue::GetDistances() const {
-        return distances_;
+    void TransportCatalogue::BuildStopsSearch() {
+        stops_search_.clear();
+        stops_search_.reserve(stops_.size());
+        search_names_.clear();
+        for (const auto& stop : stops_) {
+            const auto name = detail::FoldCase(stop.name);
+            stops_search_.push_back({
+                static_cast<uint32_t>(search_names_.size()),
+                static_cast<uint32_t>(name.size()), stop.id });
+            search_names_.insert(search_names_.end(), name.begin(),
+                                 name.end());
+        }
+        auto name_of = [this](const SearchEntry& entry) {
+            return std::string_view(search_names_.data() + entry.name_offset,
+                                    entry.name_size);
+        };
+        std::sort(stops_search_.begin(), stops_search_.end(),
+            [this, &name_of](const SearchEntry& lhs, const SearchEntry& rhs) {
+                return std::pair(name_of(lhs), stops_[lhs.stop].name) <
+                       std::pair(name_of(rhs), stops_[rhs.stop].name);
+            });
     }
 
-    void TransportCatalogue::Clear() {
-        for (auto& [_, bus] : stop_buses_map_) {
-            bus.clear();
+    void TransportCatalogue::OrderStopsAlongHilbertCurve() {
+        if (stops_.empty()) {
+            return;
         }
-        stop_buses_map_.clear();
 
-        distances_.clear();
+        double min_lat = stops_.front().latitude;
+        double max_lat = min_lat;
+        double min_lng = stops_.front().longitude;
+        double max_lng = min_lng;
+        for (const auto& stop : stops_) {
+            min_lat = std::min(min_lat, stop.latitude);
+            max_lat = std::max(max_lat, stop.latitude);
+            min_lng = std::min(min_lng, stop.longitude);
+            max_lng = std::max(max_lng, stop.longitude);
+        }
 
-        for (auto& [_, bus] : buses_map_) {
-            bus->stops.clear();
+        const double cells = static_cast<double>(
+            (1u << HILBERT_ORDER) - 1);
+        auto to_cell = [cells](double value, double min, double max) {
+            return max > min ? static_cast<uint32_t>(
+                (value - min) / (max - min) * cells) : 0u;
+        };
+
+        std::vector<std::pair<uint64_t, dom::StopId>> order;
+        order.reserve(stops_.size());
+        for (const auto& stop : stops_) {
+            order.push_back({ detail::HilbertIndex(
+                to_cell(stop.longitude, min_lng, max_lng),
+                to_cell(stop.latitude, min_lat, max_lat)), stop.id });
+        }
+        std::stable_sort(order.begin(), order.end(),
+            [](const auto& lhs, const auto& rhs) {
+                return lhs.first < rhs.first;
+            });
+
+        // Stops get new ids, so every index keyed by a stop is
+        // rebuilt. Names stay in the pool.
+        std::vector<dom::Stop> stops;
+        stops.reserve(stops_.size());
+        std::vector<dom::StopId> new_ids(stops_.size());
+        for (const auto& [_, id] : order) {
+            new_ids[id] = static_cast<dom::StopId>(stops.size());
+            stops.push_back(stops_[id]);
+            stops.back().id = new_ids[id];
+            stops_map_[stops.back().name] = new_ids[id];
         }
-        buses_map_.clear();
-        buses_.clear();
 
-        stops_map_.clear();
-        stops_.clear();
-    }
+        for (auto& stop : route_stops_) {
+            stop = new_ids[stop];
+        }
 
-    // private:
+        DistanceTable distances;
+        distances.Reserve(distances_.GetSize());
+        distances_.ForEach(
+            [&distances, &new_ids](dom::StopId from, dom::StopId to,
+                                   int distance) {
+                distances.Set(new_ids[from], new_ids[to], distance);
+            });
+        distances_ = std::move(distances);
 
-    void TransportCatalogue::InsertBusesToStop(dom::Bus* bus) {
-        for (const auto& stop : bus->stops) {
-            stop_buses_map_[stop].insert(bus);
-        }
+        stops_ = std::move(stops);
     }
 
-} // namespace cat
\ No newline at end of file
+} // namespace cat
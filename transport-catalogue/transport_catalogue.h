@@ -1,10 +1,15 @@
 #pragma once
 
+#include "distance_table.h"
 #include "domain.h"
 #include "geo.h"
+#include "ranges.h"
+#include "spatial_index.h"
+#include "string_pool.h"
 
-#include <deque>
-#include <set>
+#include <limits>
+#include <memory>
+#include <optional>
 #include <stdexcept>
 #include <string>
 #include <vector>
@@ -13,55 +18,41 @@
 
 #include <iostream>
 
-namespace cat {
-
-    namespace detail {
-        struct Buscomp final {
-            bool operator() (const dom::Bus* left,
-                const dom::Bus* right) const;
-        };
-
-        struct TwoStopsHasher {
-            size_t operator()(
-                const std::pair<dom::Stop*, dom::Stop*> stops) const;
-        };
-    }
+namespace serialization {
+    class FlatBase;
+} // namespace serialization
 
-    using SetBus = std::set<dom::Bus*, detail::Buscomp>;
-    using MapStopsDistance = 
-          std::unordered_map<std::pair<dom::Stop*, dom::Stop*>,
-                             int, detail::TwoStopsHasher>;
+namespace cat {
 
-    struct StopsDistance {
-        std::string_view from_stop;
-        std::string_view to_stop;
-        int distance;
-    };
+    class CatalogueBuilder;
 
+    // Read-only after it is made by CatalogueBuilder. Stops and buses
+    // refer to the names and routes kept here, so a catalogue can be
+    // moved but not copied.
     class TransportCatalogue {
     public:
         TransportCatalogue() = default;
-
-        void AddStop(std::string_view stop_name,
-            double latitude, double longitude);
-        void AddStop(const dom::Stop& stop);
-
-        void AddStopDistances(std::string_view stop_name,
-            const std::vector<std::pair<std::string, int>>&
-            distances);
-        void AddStopDistances(const std::vector<StopsDistance>&
-            stops_distances);
-
-        void AddBus(std::string_view bus_name, bool is_annular,
-            const std::vector<std::string>& stop_names);
+        TransportCatalogue(const TransportCatalogue&) = delete;
+        TransportCatalogue& operator=(const TransportCatalogue&) = delete;
+        TransportCatalogue(TransportCatalogue&&) = default;
+        TransportCatalogue& operator=(TransportCatalogue&&) = default;
+
+        // Names are resolved once at the boundary; everything inside
+        // is addressed by dense ids.
+        std::optional<dom::StopId> GetStopId(
+            std::string_view stop_name) const;
+        std::optional<dom::BusId> GetBusId(
+            std::string_view bus_name) const;
 
         const dom::Stop* GetStop(std::string_view stop_name) const;
         const dom::Bus* GetBus(std::string_view bus_name) const;
+        const dom::Stop& GetStop(dom::StopId stop_id) const;
+        const dom::Bus& GetBus(dom::BusId bus_id) const;
 
         int DistanceBetweenStops(std::string_view stop_name1,
             std::string_view stop_name2) const;
-        int DistanceBetweenStops(dom::Stop* stop1,
-            dom::Stop* stop2) const;
+        int DistanceBetweenStops(dom::StopId stop1,
+            dom::StopId stop2) const;
 
         double RouteGeoLength(std::string_view bus_name) const;
         int RouteLength(std::string_view bus_name) const;
@@ -72,28 +63,132 @@ namespace cat {
         const dom::StopInfo GetStopInfo(
             std::string_view stop_name) const;
 
-        const std::unordered_map<std::string_view, dom::Stop*>&
+        const std::unordered_map<std::string_view, dom::StopId>&
             GetStops() const;
-        const std::unordered_map<std::string_view, dom::Bus*>&
+        const std::vector<dom::Stop>& GetStopsList() const;
+        const std::unordered_map<std::string_view, dom::BusId>&
             GetBuses() const;
-        const std::unordered_map<dom::Stop*, SetBus>&
-            GetStopBuses() const;
-        const MapStopsDistance& GetDistances() const;
-
+        const std::vector<dom::Bus>& GetBusesList() const;
+        // Buses through the stop sorted by name.
+        ranges::Range<const dom::BusId*> GetStopBuses(
+            dom::StopId stop_id) const;
+        const DistanceTable& GetDistances() const;
+
+        // Stops within `radius` meters of the point with the distances
+        // to them, the nearest first, at most `limit` of them.
+        std::vector<std::pair<dom::StopId, double>> NearbyStops(
+            double latitude, double longitude, double radius,
+            size_t limit = std::numeric_limits<size_t>::max()) const;
+
+        // Buses going from one stop to the other without a transfer,
+        // by name, each with the fewest stops on. A bus which is not a
+        // roundtrip goes both ways.
+        std::vector<dom::DirectBus> DirectBuses(dom::StopId from_stop,
+                                                dom::StopId to_stop) const;
+
+        // Stops whose names start with `prefix` ignoring case (Latin and
+        // Cyrillic letters), in the order of their case-folded names,
+        // at most `limit` of them.
+        std::vector<dom::StopId> SearchStops(std::string_view prefix,
+            size_t limit = std::numeric_limits<size_t>::max()) const;
+
+        // Keeps the memory taken by the names and the routes for the
+        // next base.
         void Clear();
 
     private:
-        std::deque<dom::Stop> stops_;
-        std::unordered_map<std::string_view, dom::Stop*>
+        friend class CatalogueBuilder;
+        friend class serialization::FlatBase;
+
+        StringPool names_;
+        // A mapped base the names point into, if loaded from one.
+        std::shared_ptr<const void> storage_;
+        std::vector<dom::Stop> stops_;
+        std::unordered_map<std::string_view, dom::StopId>
             stops_map_;
-        std::deque<dom::Bus> buses_;
-        std::unordered_map<std::string_view, dom::Bus*>
+        std::vector<dom::Bus> buses_;
+        std::unordered_map<std::string_view, dom::BusId>
             buses_map_;
 
-        std::unordered_map<dom::Stop*, SetBus> stop_buses_map_;
-        MapStopsDistance distances_;
-
-        void InsertBusesToStop(dom::Bus* bus);
+        // Stops of the bus i are route_stops_[route_offsets_[i]] up
+        // to route_stops_[route_offsets_[i + 1]].
+        std::vector<dom::StopId> route_stops_;
+        std::vector<uint32_t> route_offsets_ = { 0 };
+
+        // Buses of the stop i are stop_buses_[stop_buses_offsets_[i]]
+        // up to stop_buses_[stop_buses_offsets_[i + 1]].
+        std::vector<uint32_t> stop_buses_offsets_;
+        std::vector<dom::BusId> stop_buses_;
+        DistanceTable distances_;
+        geo::SpatialIndex stops_index_;
+
+        // Bit r of the row of a stop is set if the bus of rank r by
+        // name passes it; rows are stop_bus_words_ words long.
+        size_t stop_bus_words_ = 0;
+        std::vector<uint64_t> stop_bus_bits_;
+        std::vector<dom::BusId> buses_by_name_;
+        // Route stops of every bus with their positions in the route,
+        // sorted; laid out by route_offsets_ like route_stops_.
+        struct RoutePosition {
+            dom::StopId stop = 0;
+            uint32_t position = 0;
+        };
+        std::vector<RoutePosition> route_positions_;
+
+        // Case-folded stop names, sorted, for the prefix search. The
+        // names are offsets into search_names_.
+        struct SearchEntry {
+            uint32_t name_offset = 0;
+            uint32_t name_size = 0;
+            dom::StopId stop = 0;
+        };
+        std::vector<SearchEntry> stops_search_;
+        std::vector<char> search_names_;
+
+        // The queries read the arrays above through these views, which
+        // a flat base points into its mapping instead.
+        struct Views {
+            ranges::Range<const dom::StopId*> route_stops{ nullptr, nullptr };
+            ranges::Range<const uint32_t*> route_offsets{ nullptr, nullptr };
+            ranges::Range<const uint32_t*> stop_buses_offsets{
+                nullptr, nullptr };
+            ranges::Range<const dom::BusId*> stop_buses{ nullptr, nullptr };
+            ranges::Range<const uint64_t*> stop_bus_bits{ nullptr, nullptr };
+            ranges::Range<const dom::BusId*> buses_by_name{
+                nullptr, nullptr };
+            ranges::Range<const RoutePosition*> route_positions{
+                nullptr, nullptr };
+            ranges::Range<const SearchEntry*> stops_search{
+                nullptr, nullptr };
+            ranges::Range<const char*> search_names{ nullptr, nullptr };
+        };
+        Views views_;
+
+        double RouteGeoLength(const dom::Bus& bus) const;
+        int RouteLength(const dom::Bus& bus) const;
+        dom::BusStats ComputeBusStats(const dom::Bus& bus) const;
+        // For the buses whose statistics were not restored.
+        void ComputeMissingStats();
+
+        // Called by the builder when all the stops, distances and
+        // buses are in place. Stores the stops in the order of a
+        // Hilbert curve over their coordinates, so that stops close on
+        // the map are close in memory and get close vertex ids in the
+        // router, fills in the distances given in one direction only,
+        // builds the name, stop-to-buses and spatial indexes and
+        // computes the bus statistics; the indexes and the statistics
+        // are built on several threads at once.
+        void Finalize();
+
+        void BindViews();
+        void BindRouteStops();
+        void BuildStopBuses();
+        void BuildDirectIndex();
+        void BuildStopsIndex();
+        void BuildStopsSearch();
+        std::optional<int> SpanCount(dom::BusId bus_id,
+            dom::StopId from_stop, dom::StopId to_stop) const;
+        void OrderStopsAlongHilbertCurve();
     };
 
-} // namespace cat
\ No newline at end of file
+} // namespace cat
@@ -1,29 +1,106 @@
 #include "transport_router.h"
 
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
 namespace cat {
 
-    const double METERS_PER_SECOND = 16.666666667;
+    const char MATRIX_SIGNATURE[] = "TCMX";
+    const uint32_t MATRIX_VERSION = 1;
+    const size_t MATRIX_BLOCK_ROWS = 256;
+
+    namespace detail {
+        template <typename Value>
+        void WriteValue(std::ostream& out, Value value) {
+            out.write(reinterpret_cast<const char*>(&value),
+                      sizeof(value));
+        }
+    }
+
+    bool ScenarioMask::IsEmpty() const {
+        return closed_stops.empty() && closed_buses.empty() &&
+            hops_ahead.empty();
+    }
+
+    bool ScenarioMask::IsStopClosed(dom::StopId stop_id) const {
+        return !closed_stops.empty() && closed_stops[stop_id];
+    }
+
+    bool ScenarioMask::IsRideOpen(dom::BusId bus_id,
+        uint32_t from_position, uint32_t to_position) const {
+
+        if (!closed_buses.empty() && closed_buses[bus_id]) {
+            return false;
+        }
+        if (hops_ahead.empty()) {
+            return true;
+        }
+        // Hops from position i to j going ahead are the hops before
+        // j less the hops before i; likewise going back.
+        if (from_position < to_position) {
+            const auto& ahead = hops_ahead[bus_id];
+            return ahead[to_position] == ahead[from_position];
+        }
+        const auto& back = hops_back[bus_id];
+        return back[from_position] == back[to_position];
+    }
 
     void TransportRouter::BuildGraph(const TransportCatalogue& db) {
 
-        Clear();
+        BuildEdges(db);
+
+        // Components may come with the base already.
+        if (components_.strong.size() != graph_.GetVertexCount()) {
+            components_ = graph::FindComponents(graph_);
+        }
+
+        router_ = std::make_unique<graph::Router<double>>(
+            graph_, components_.weak);
+
+        profile_router_.reset();
+    }
+
+    void TransportRouter::BuildComponents(const TransportCatalogue& db) {
+        BuildEdges(db);
+        components_ = graph::FindComponents(graph_);
+    }
+
+    void TransportRouter::BuildEdges(const TransportCatalogue& db) {
+
+        graph_.Clear();
+        stops_.clear();
+        rides_.clear();
+        stops_index_.Clear();
+        centrality_.Clear();
+        db_ = &db;
 
-        const auto& stops = db.GetStops();
+        // Vertex ids are the stop ids of the catalogue.
+        const auto& stops = db.GetStopsList();
 
         auto stops_count = stops.size();
-        stops_.resize(stops_count);
+        stops_.reserve(stops_count);
         graph_.VertexResize(stops_count);
-        size_t i = 0;
-        for (const auto& [stop_name, stop] : stops) {
-            stops_[i] = stop;
-            stops_ids_[stop_name] = i++;
+        for (const auto& stop : stops) {
+            stops_.push_back(&stop);
         }
 
-        for (const auto& [_, bus] : db.GetBuses()) {
+        std::vector<geo::Coordinates> stops_coordinates;
+        stops_coordinates.reserve(stops_count);
+        for (const auto& stop : stops_) {
+            stops_coordinates.push_back({ stop->latitude,
+                                          stop->longitude });
+        }
+        stops_index_.Build(stops_coordinates,
+            routing_settings_.transfer_radius > 0
+            ? routing_settings_.transfer_radius
+            : routing_settings_.walking_radius);
+
+        for (const auto& bus : db.GetBusesList()) {
             AddEdges(bus, db);
         }
 
-        router_ = std::make_unique<graph::Router<double>>(graph_);
+        AddWalkEdges();
     }
 
     graph::DirectedWeightedGraph<double>&
@@ -31,56 +108,87 @@ namespace cat {
         return graph_;
     }
 
-    std::vector<dom::Stop*>&
+    std::vector<const dom::Stop*>&
     TransportRouter::GetStops() {
         return stops_;
     }
 
-    std::unordered_map<std::string_view, size_t>&
-    TransportRouter::GetStopsIds() {
-        return stops_ids_;
+    std::unique_ptr<graph::Router<double>>&
+    TransportRouter::GetRouter() {
+        return router_;
     }
 
-    std::unordered_map<graph::EdgeId, std::string_view>&
-    TransportRouter::GetBusesNames() {
-        return buses_names_;
+    graph::Components& TransportRouter::GetComponents() {
+        return components_;
     }
 
-    std::unordered_map<graph::EdgeId, int>&
-    TransportRouter::GetStopsCounts() {
-        return stops_counts_;
+    const graph::Centrality& TransportRouter::GetCentrality() const {
+        std::lock_guard lock(centrality_mutex_);
+        if (centrality_.IsEmpty()) {
+            auto for_each_passed = [this](graph::EdgeId edge_id,
+                                          auto&& visit) {
+                const Ride& ride = rides_[edge_id];
+                if (ride.bus == NO_BUS) {
+                    return;
+                }
+                const auto& stops = db_->GetBus(ride.bus).stops;
+                const auto [first, last] = std::minmax(ride.from_position,
+                                                       ride.to_position);
+                for (uint32_t i = first + 1; i < last; ++i) {
+                    visit(stops[i]);
+                }
+            };
+            centrality_ = graph::ComputeCentrality(graph_, 0,
+                                                   for_each_passed);
+        }
+        return centrality_;
     }
 
-    std::unique_ptr<graph::Router<double>>&
-    TransportRouter::GetRouter() {
-        return router_;
+    const ProfileRouter& TransportRouter::GetProfileRouter() const {
+        std::lock_guard lock(profile_router_mutex_);
+        if (!profile_router_) {
+            std::vector<ProfileRouter::Walk> walks;
+            for (graph::EdgeId edge_id = 0; edge_id < rides_.size();
+                 ++edge_id) {
+                if (rides_[edge_id].bus == NO_BUS) {
+                    const auto& edge = graph_.GetEdge(edge_id);
+                    walks.push_back({ static_cast<dom::StopId>(edge.from),
+                                      static_cast<dom::StopId>(edge.to),
+                                      edge.weight });
+                }
+            }
+            profile_router_.emplace();
+            if (db_ != nullptr) {
+                profile_router_->Build(*db_, routing_settings_, walks);
+            }
+        }
+        return *profile_router_;
     }
 
-    void TransportRouter::AddEdges(const dom::Bus* bus,
+    void TransportRouter::AddEdges(const dom::Bus& bus,
         const TransportCatalogue& db) {
 
-        const auto& bus_stops = bus->stops;
+        const auto& bus_stops = bus.stops;
         auto bus_stops_count = bus_stops.size();
         if (bus_stops_count == 0) {
             return;
         }
 
         double bus_speed = 
-            routing_settings_.bus_velocity * METERS_PER_SECOND;
+            routing_settings_.bus_velocity *
+            dom::METERS_PER_MINUTE_PER_KMH;
         double bus_wait_time =
             routing_settings_.bus_wait_time;
 
         for (size_t i = 0; i < bus_stops_count - 1; ++i) {
             for (size_t j = i + 1; j < bus_stops_count; ++j) {
-                if (bus_stops[i]->name == bus_stops[j]->name) {
+                if (bus_stops[i] == bus_stops[j]) {
                     continue;
                 }
                 int distance = 0;
                 double trip_time = bus_wait_time;
-                graph::VertexId from_vid = 
-                    stops_ids_.at(bus_stops[i]->name);
-                graph::VertexId to_vid = 
-                    stops_ids_.at(bus_stops[j]->name);
+                graph::VertexId from_vid = bus_stops[i];
+                graph::VertexId to_vid = bus_stops[j];
 
                 for (size_t s = i; s < j; ++s) {
                     distance +=
@@ -90,28 +198,25 @@ namespace cat {
                 trip_time += (distance * 1.0 / bus_speed);
                 graph::Edge<double> edge = { from_vid , to_vid,
                                              trip_time };
-                graph::EdgeId edge_id = graph_.AddEdge(edge);
-
-                buses_names_[edge_id] = bus->name;
-                stops_counts_[edge_id] = j - i;
+                graph_.AddEdge(edge);
+                rides_.push_back({ bus.id, static_cast<uint32_t>(i),
+                                   static_cast<uint32_t>(j) });
             }
         }
 
-        if (bus->is_annular) {
+        if (bus.is_annular) {
             return;
         }
 
         for (size_t i = bus_stops_count - 1; i > 0; --i) {
             for (size_t j = i - 1; j + 1 > 0; --j) {
-                if (bus_stops[i]->name == bus_stops[j]->name) {
+                if (bus_stops[i] == bus_stops[j]) {
                     continue;
                 }
                 int distance = 0;
                 double trip_time = bus_wait_time;
-                graph::VertexId from_vid = 
-                    stops_ids_.at(bus_stops[i]->name);
-                graph::VertexId to_vid = 
-                    stops_ids_.at(bus_stops[j]->name);
+                graph::VertexId from_vid = bus_stops[i];
+                graph::VertexId to_vid = bus_stops[j];
 
                 for (size_t s = i; s > j; --s) {
                     distance +=
@@ -121,66 +226,421 @@ namespace cat {
                 trip_time += (distance * 1.0 / bus_speed);
                 graph::Edge<double> edge = { from_vid , to_vid,
                                              trip_time };
-                graph::EdgeId edge_id = graph_.AddEdge(edge);
-
-                buses_names_[edge_id] = bus->name;
-                stops_counts_[edge_id] = i - j;
+                graph_.AddEdge(edge);
+                rides_.push_back({ bus.id, static_cast<uint32_t>(i),
+                                   static_cast<uint32_t>(j) });
             }
         }
 
     }
 
+    void TransportRouter::AddWalkEdges() {
+
+        if (!(routing_settings_.transfer_radius > 0)) {
+            return;
+        }
+
+        const double walking_speed =
+            routing_settings_.walking_velocity *
+            dom::METERS_PER_MINUTE_PER_KMH;
+
+        for (graph::VertexId from_vid = 0; from_vid < stops_.size();
+             ++from_vid) {
+            const auto nearby = stops_index_.FindInRadius(
+                { stops_[from_vid]->latitude, stops_[from_vid]->longitude },
+                routing_settings_.transfer_radius);
+            for (const auto& [to_vid, distance] : nearby) {
+                if (to_vid == from_vid) {
+                    continue;
+                }
+                graph::Edge<double> edge = { from_vid, to_vid,
+                                             distance / walking_speed };
+                graph_.AddEdge(edge);
+                rides_.push_back({});
+            }
+        }
+    }
+
     std::vector<dom::TripAction>
-        TransportRouter::GetRoute(std::string_view from_stop,
-            std::string_view to_stop, double bus_wait_time) {
+        TransportRouter::GetRoute(dom::StopId from_id,
+            dom::StopId to_id, double bus_wait_time) const {
+
+        dom::TripAction trip_action;
+
+        if (from_id == to_id) {
+            trip_action.type = dom::ActionType::IDLE;
+            return { trip_action };
+        }
 
-        if (stops_ids_.count(from_stop) == 0 ||
-            stops_ids_.count(to_stop) == 0) {
+        if (!components_.IsReachable(from_id, to_id)) {
             return {};
         }
 
-        auto from_id = stops_ids_.at(from_stop);
-        auto to_id = stops_ids_.at(to_stop);
+        std::vector<dom::TripAction> result;
+        if (const auto info = router_->BuildRoute(from_id, to_id)) {
+            for (const auto eid : info->edges) {
+                AddTripActions(eid, bus_wait_time, result);
+            }
+        }
+
+        return result;
+    }
 
-        dom::TripAction trip_action;
+    std::vector<dom::TripAction>
+        TransportRouter::GetRoute(dom::StopId from_id,
+            dom::StopId to_id, const ScenarioMask& mask) const {
 
+        if (mask.IsStopClosed(from_id) || mask.IsStopClosed(to_id)) {
+            return {};
+        }
         if (from_id == to_id) {
+            dom::TripAction trip_action;
             trip_action.type = dom::ActionType::IDLE;
             return { trip_action };
         }
 
+        const graph::DijkstraRouter<double> router(graph_);
+        const auto info = router.BuildRoute({ { from_id, 0.0 } },
+            { { to_id, 0.0 } }, [this, &mask](graph::EdgeId edge_id) {
+                return IsEdgeOpen(edge_id, mask);
+            });
+
+        std::vector<dom::TripAction> result;
+        if (info) {
+            for (const auto eid : info->edges) {
+                AddTripActions(eid, routing_settings_.bus_wait_time,
+                               result);
+            }
+        }
+        return result;
+    }
+
+    std::vector<dom::TripAction>
+        TransportRouter::GetRoute(geo::Coordinates from_point,
+            geo::Coordinates to_point, const ScenarioMask& mask) const {
+
+        const double walking_speed =
+            routing_settings_.walking_velocity *
+            dom::METERS_PER_MINUTE_PER_KMH;
+
+        dom::TripAction trip_action;
+        trip_action.type = dom::ActionType::WALK;
+
+        const double direct_distance =
+            geo::ComputeDistance(from_point, to_point);
+        std::optional<double> direct_time;
+        if (direct_distance <= routing_settings_.walking_radius) {
+            direct_time = direct_distance / walking_speed;
+        }
+
+        const graph::DijkstraRouter<double> router(graph_);
+        const auto info = router.BuildRoute(
+            GetWalkingTerminals(from_point, mask),
+            GetWalkingTerminals(to_point, mask),
+            [this, &mask](graph::EdgeId edge_id) {
+                return IsEdgeOpen(edge_id, mask);
+            });
+
+        if (direct_time && (!info || *direct_time <= info->weight)) {
+            trip_action.time = *direct_time;
+            return { trip_action };
+        }
+        if (!info) {
+            return {};
+        }
+
         std::vector<dom::TripAction> result;
-        std::optional<graph::Router<double>::RouteInfo> info;
-        if ((*router_.get()).BuildRoute(from_id, to_id).has_value()) {
-            info = *router_.get()->BuildRoute(from_id, to_id);
+
+        const dom::Stop* source = stops_[info->source];
+        trip_action.to_stop = source->name;
+        trip_action.time = geo::ComputeDistance(from_point,
+            { source->latitude, source->longitude }) / walking_speed;
+        result.push_back(trip_action);
+
+        for (const auto eid : info->edges) {
+            AddTripActions(eid, routing_settings_.bus_wait_time, result);
         }
 
-        if (info.has_value()) {
-            for (size_t i = 0; i < info.value().edges.size(); ++i) {
-                trip_action.type = dom::ActionType::WAIT;
-                auto vid = 
-                    graph_.GetEdge(info.value().edges.at(i)).from;
-                trip_action.name = stops_[vid]->name;
- //               trip_action.span_count = 0;
-                trip_action.time = bus_wait_time;
+        const dom::Stop* target = stops_[info->target];
+        trip_action.name = target->name;
+        trip_action.to_stop.clear();
+        trip_action.span_count = 0;
+        trip_action.time = geo::ComputeDistance(
+            { target->latitude, target->longitude }, to_point) /
+            walking_speed;
+        result.push_back(trip_action);
+
+        return result;
+    }
+
+    std::vector<dom::TripAction>
+        TransportRouter::GetScheduledRoute(dom::StopId from_id,
+            dom::StopId to_id, double departure_time,
+            const ScenarioMask& mask) const {
+
+        if (mask.IsStopClosed(from_id) || mask.IsStopClosed(to_id)) {
+            return {};
+        }
+        if (from_id == to_id) {
+            dom::TripAction trip_action;
+            trip_action.type = dom::ActionType::IDLE;
+            return { trip_action };
+        }
 
-                result.push_back(trip_action);
+        return GetProfileRouter().GetRoute(from_id, to_id, departure_time,
+                                           mask);
+    }
 
-                trip_action.type = dom::ActionType::IN_BUS;
-                auto eid = info.value().edges.at(i);
-                trip_action.name = buses_names_.at(eid);
-                trip_action.span_count = stops_counts_.at(eid);
-                trip_action.time = graph_.GetEdge(eid).weight -
-                                   bus_wait_time;
+    std::vector<dom::ProfilePoint>
+        TransportRouter::GetRouteProfile(dom::StopId from_id,
+            dom::StopId to_id,
+            double window_begin, double window_end,
+            const ScenarioMask& mask) const {
 
-                result.push_back(trip_action);
+        return GetProfileRouter().GetProfile(from_id, to_id,
+            window_begin, window_end, mask);
+    }
 
+    std::vector<std::vector<std::optional<double>>>
+        TransportRouter::GetRouteMatrix(
+            const std::vector<dom::StopId>& from_stops,
+            const std::vector<dom::StopId>& to_stops,
+            const ScenarioMask& mask) const {
+
+        std::vector<std::vector<std::optional<double>>> result;
+        result.reserve(from_stops.size());
+
+        if (mask.IsEmpty()) {
+            for (const auto from_id : from_stops) {
+                auto& row = result.emplace_back(to_stops.size());
+                for (size_t i = 0; i < to_stops.size(); ++i) {
+                    if (from_id == to_stops[i]) {
+                        row[i] = 0.0;
+                    }
+                    else if (components_.IsReachable(from_id,
+                                                     to_stops[i])) {
+                        if (const auto info =
+                            router_->BuildRoute(from_id, to_stops[i])) {
+                            row[i] = info->weight;
+                        }
+                    }
+                }
             }
+            return result;
         }
 
+        // One search per row, each settling all the row targets.
+        const graph::DijkstraRouter<double> router(graph_);
+        const std::vector<graph::VertexId> targets(to_stops.begin(),
+                                                   to_stops.end());
+        for (const auto from_id : from_stops) {
+            if (mask.IsStopClosed(from_id)) {
+                result.emplace_back(to_stops.size());
+                continue;
+            }
+            auto row = router.ComputeWeights({ { from_id, 0.0 } },
+                targets, [this, &mask](graph::EdgeId edge_id) {
+                    return IsEdgeOpen(edge_id, mask);
+                });
+            for (size_t i = 0; i < to_stops.size(); ++i) {
+                if (mask.IsStopClosed(to_stops[i])) {
+                    row[i].reset();
+                }
+            }
+            result.push_back(std::move(row));
+        }
         return result;
     }
 
+    void TransportRouter::WriteTravelTimes(std::ostream& out,
+        size_t threads_count) const {
+
+        const size_t stops_count = graph_.GetVertexCount();
+        out.write(MATRIX_SIGNATURE, sizeof(MATRIX_SIGNATURE) - 1);
+        detail::WriteValue(out, MATRIX_VERSION);
+        detail::WriteValue(out, static_cast<uint32_t>(stops_count));
+        for (const auto stop : stops_) {
+            detail::WriteValue(out,
+                static_cast<uint32_t>(stop->name.size()));
+            out.write(stop->name.data(), stop->name.size());
+        }
+
+        if (threads_count == 0) {
+            threads_count = std::max(1u, std::thread::hardware_concurrency());
+        }
+        threads_count = std::max<size_t>(1,
+            std::min(threads_count, MATRIX_BLOCK_ROWS));
+
+        std::vector<graph::VertexId> targets(stops_count);
+        for (graph::VertexId id = 0; id < stops_count; ++id) {
+            targets[id] = id;
+        }
+        const graph::DijkstraRouter<double> router(graph_);
+        auto is_open = [](graph::EdgeId) { return true; };
+
+        std::vector<float> block(
+            std::min(MATRIX_BLOCK_ROWS, stops_count) * stops_count);
+        for (size_t block_begin = 0; block_begin < stops_count;
+             block_begin += MATRIX_BLOCK_ROWS) {
+            const size_t block_end =
+                std::min(stops_count, block_begin + MATRIX_BLOCK_ROWS);
+
+            // Every thread fills the rows it takes, so they share
+            // nothing but the row counter.
+            std::atomic<size_t> next_row{ block_begin };
+            auto work = [&]() {
+                for (size_t row = next_row++; row < block_end;
+                     row = next_row++) {
+                    const auto weights = router.ComputeWeights(
+                        { { static_cast<graph::VertexId>(row), 0.0 } },
+                        targets, is_open);
+                    float* cells = block.data() +
+                        (row - block_begin) * stops_count;
+                    for (size_t i = 0; i < stops_count; ++i) {
+                        cells[i] = weights[i]
+                            ? static_cast<float>(*weights[i])
+                            : std::numeric_limits<float>::quiet_NaN();
+                    }
+                }
+            };
+            std::vector<std::thread> threads;
+            threads.reserve(threads_count - 1);
+            for (size_t i = 1; i < threads_count; ++i) {
+                threads.emplace_back(work);
+            }
+            work();
+            for (auto& thread : threads) {
+                thread.join();
+            }
+
+            out.write(reinterpret_cast<const char*>(block.data()),
+                (block_end - block_begin) * stops_count * sizeof(float));
+        }
+    }
+
+    ScenarioMask TransportRouter::MakeScenarioMask(
+        const TransportCatalogue& db,
+        const dom::Scenario& scenario) const {
+
+        ScenarioMask mask;
+
+        for (const auto& name : scenario.stops) {
+            if (const auto stop_id = db.GetStopId(name)) {
+                mask.closed_stops.resize(stops_.size(), false);
+                mask.closed_stops[*stop_id] = true;
+            }
+        }
+
+        for (const auto& name : scenario.buses) {
+            if (const auto bus_id = db.GetBusId(name)) {
+                mask.closed_buses.resize(db.GetBusesList().size(),
+                                         false);
+                mask.closed_buses[*bus_id] = true;
+            }
+        }
+
+        std::vector<std::pair<dom::StopId, dom::StopId>> hops;
+        for (const auto& [from, to] : scenario.hops) {
+            const auto from_id = db.GetStopId(from);
+            const auto to_id = db.GetStopId(to);
+            if (from_id && to_id) {
+                hops.push_back({ *from_id, *to_id });
+            }
+        }
+        if (hops.empty()) {
+            return mask;
+        }
+        std::sort(hops.begin(), hops.end());
+
+        auto is_closed = [&hops](dom::StopId from, dom::StopId to) {
+            return std::binary_search(hops.begin(), hops.end(),
+                                      std::pair{ from, to });
+        };
+        const auto& buses = db.GetBusesList();
+        mask.hops_ahead.resize(buses.size());
+        mask.hops_back.resize(buses.size());
+        for (const auto& bus : buses) {
+            const auto& stops = bus.stops;
+            auto& ahead = mask.hops_ahead[bus.id];
+            auto& back = mask.hops_back[bus.id];
+            ahead.assign(stops.size(), 0);
+            back.assign(stops.size(), 0);
+            for (size_t i = 1; i < stops.size(); ++i) {
+                ahead[i] = ahead[i - 1] +
+                    (is_closed(stops[i - 1], stops[i]) ? 1 : 0);
+                back[i] = back[i - 1] +
+                    (is_closed(stops[i], stops[i - 1]) ? 1 : 0);
+            }
+        }
+        return mask;
+    }
+
+    std::vector<graph::DijkstraRouter<double>::Terminal>
+        TransportRouter::GetWalkingTerminals(
+            geo::Coordinates point, const ScenarioMask& mask) const {
+
+        const double walking_speed =
+            routing_settings_.walking_velocity *
+            dom::METERS_PER_MINUTE_PER_KMH;
+
+        std::vector<graph::DijkstraRouter<double>::Terminal> terminals;
+        for (const auto& [vid, distance] : stops_index_.FindInRadius(
+             point, routing_settings_.walking_radius)) {
+            if (mask.IsStopClosed(static_cast<dom::StopId>(vid))) {
+                continue;
+            }
+            terminals.push_back({ vid, distance / walking_speed });
+        }
+        return terminals;
+    }
+
+    bool TransportRouter::IsEdgeOpen(graph::EdgeId edge_id,
+        const ScenarioMask& mask) const {
+
+        const auto& edge = graph_.GetEdge(edge_id);
+        if (mask.IsStopClosed(edge.from) || mask.IsStopClosed(edge.to)) {
+            return false;
+        }
+
+        const auto& ride = rides_[edge_id];
+        if (ride.bus == NO_BUS) {
+            return true;
+        }
+        return mask.IsRideOpen(ride.bus, ride.from_position,
+                               ride.to_position);
+    }
+
+    void TransportRouter::AddTripActions(graph::EdgeId edge_id,
+        double bus_wait_time,
+        std::vector<dom::TripAction>& result) const {
+
+        const auto& edge = graph_.GetEdge(edge_id);
+        const auto& ride = rides_[edge_id];
+        dom::TripAction trip_action;
+
+        if (ride.bus == NO_BUS) {
+            trip_action.type = dom::ActionType::WALK;
+            trip_action.name = stops_[edge.from]->name;
+            trip_action.to_stop = stops_[edge.to]->name;
+            trip_action.time = edge.weight;
+            result.push_back(trip_action);
+            return;
+        }
+
+        trip_action.type = dom::ActionType::WAIT;
+        trip_action.name = stops_[edge.from]->name;
+        trip_action.time = bus_wait_time;
+        result.push_back(trip_action);
+
+        trip_action.type = dom::ActionType::IN_BUS;
+        trip_action.name = db_->GetBus(ride.bus).name;
+        trip_action.span_count = ride.from_position < ride.to_position
+            ? static_cast<int>(ride.to_position - ride.from_position)
+            : static_cast<int>(ride.from_position - ride.to_position);
+        trip_action.time = edge.weight - bus_wait_time;
+        result.push_back(trip_action);
+    }
+
     const bool TransportRouter::RouterIsSet() const {
         return router_is_set_;
     }
@@ -194,12 +654,20 @@ namespace cat {
         return routing_settings_;
     }
 
+    const dom::RoutingSettings&
+        TransportRouter::GetRoutingSettings() const {
+        return routing_settings_;
+    }
+
     void TransportRouter::Clear() {
         graph_.Clear();
         stops_.clear();
-        stops_ids_.clear();
-        buses_names_.clear();
-        stops_counts_.clear();
+        rides_.clear();
+        stops_index_.Clear();
+        components_.Clear();
+        centrality_.Clear();
+        db_ = nullptr;
+        profile_router_.reset();
     }
 
 } // namespace cat
\ No newline at end of file
@@ -1,36 +1,123 @@
 #pragma once
 
+#include "centrality.h"
+#include "components.h"
+#include "dijkstra_router.h"
+#include "profile_router.h"
 #include "router.h"
+#include "spatial_index.h"
 #include "transport_catalogue.h"
 
+#include <cstdint>
+#include <limits>
 #include <memory>
+#include <mutex>
+#include <optional>
+#include <ostream>
 #include <string_view>
 
 namespace cat {
 
+    // A what-if scenario resolved for the search. Routes with it
+    // avoid rides of the closed buses, boarding and leaving buses at
+    // the closed stops (buses still pass through them), walks to and
+    // from those stops and rides over the closed hops.
+    struct ScenarioMask {
+        // By stop id and bus id; empty when nothing is closed.
+        std::vector<bool> closed_stops;
+        std::vector<bool> closed_buses;
+        // Closed hops of a bus route before a route position, going
+        // ahead and going back. Empty when no hop is closed.
+        std::vector<std::vector<uint32_t>> hops_ahead;
+        std::vector<std::vector<uint32_t>> hops_back;
+
+        bool IsEmpty() const;
+        bool IsStopClosed(dom::StopId stop_id) const;
+        // A ride of the bus from one route position to another.
+        bool IsRideOpen(dom::BusId bus_id, uint32_t from_position,
+                        uint32_t to_position) const;
+    };
+
     class TransportRouter {
     public:
 
         void BuildGraph(const TransportCatalogue& db);
 
+        // Builds the edges only to find the components stored in the
+        // base; the routing tables are left for BuildGraph.
+        void BuildComponents(const TransportCatalogue& db);
+
+        // Builds the edges alone, enough for WriteTravelTimes.
+        void BuildEdges(const TransportCatalogue& db);
+
         std::vector<dom::TripAction>
-        GetRoute(std::string_view from_stop,
-                 std::string_view to_stop, double bus_wait_time);
+        GetRoute(dom::StopId from_stop, dom::StopId to_stop,
+                 double bus_wait_time) const;
 
-        graph::DirectedWeightedGraph<double>& GetGraph();
+        // Searched on demand, without the precomputed tables.
+        std::vector<dom::TripAction>
+        GetRoute(dom::StopId from_stop, dom::StopId to_stop,
+                 const ScenarioMask& mask) const;
 
-        std::vector<dom::Stop*>& GetStops();
-        std::unordered_map<std::string_view, size_t>& GetStopsIds();
+        std::vector<dom::TripAction>
+        GetRoute(geo::Coordinates from_point,
+                 geo::Coordinates to_point,
+                 const ScenarioMask& mask = {}) const;
+
+        // Total times of the routes from each of `from_stops` to each of
+        // `to_stops`, none for the routes not found.
+        std::vector<std::vector<std::optional<double>>>
+        GetRouteMatrix(const std::vector<dom::StopId>& from_stops,
+                       const std::vector<dom::StopId>& to_stops,
+                       const ScenarioMask& mask = {}) const;
+
+        // Writes the travel times between all the stops, found by
+        // single-source searches on `threads_count` threads (all cores
+        // by default) over the graph edges alone. Rows are searched
+        // and written MATRIX_BLOCK_ROWS at a time, so only that many
+        // rows are held in memory. The output, in the host byte order:
+        //   "TCMX", uint32 version, uint32 stop count,
+        //   per stop id: uint32 name length, name bytes,
+        //   per stop id: a row of float32 minutes to every stop id,
+        //   NaN where there is no route.
+        void WriteTravelTimes(std::ostream& out,
+                              size_t threads_count = 0) const;
+
+        // Names the catalogue does not know are left out.
+        ScenarioMask MakeScenarioMask(const TransportCatalogue& db,
+                                      const dom::Scenario& scenario) const;
+
+        std::vector<dom::TripAction>
+        GetScheduledRoute(dom::StopId from_stop, dom::StopId to_stop,
+                          double departure_time,
+                          const ScenarioMask& mask = {}) const;
 
-        std::unordered_map<graph::EdgeId, std::string_view>& GetBusesNames();
-        std::unordered_map<graph::EdgeId, int>& GetStopsCounts();
+        std::vector<dom::ProfilePoint>
+        GetRouteProfile(dom::StopId from_stop, dom::StopId to_stop,
+                        double window_begin, double window_end,
+                        const ScenarioMask& mask = {}) const;
+
+        graph::DirectedWeightedGraph<double>& GetGraph();
+
+        // Vertex ids are the stop ids of the catalogue.
+        std::vector<const dom::Stop*>& GetStops();
 
         std::unique_ptr<graph::Router<double>>& GetRouter();
 
+        graph::Components& GetComponents();
+
+        // Betweenness of the stops and mean times from them over the
+        // routing graph, computed on all cores on the first call. A
+        // ride joins any two stops of a route in one edge, so the
+        // stops it passes by are credited with its routes as well.
+        // Safe to call from several threads at once.
+        const graph::Centrality& GetCentrality() const;
+
         const bool RouterIsSet() const;
         const void SetRouterIsSet(bool value);
 
         dom::RoutingSettings& GetRoutingSettings();
+        const dom::RoutingSettings& GetRoutingSettings() const;
 
         void Clear();
 
@@ -40,15 +127,49 @@ namespace cat {
         bool router_is_set_ = false;
         dom::RoutingSettings routing_settings_;
 
-        std::vector<dom::Stop*> stops_;
-        std::unordered_map<std::string_view, size_t> stops_ids_;
+        std::vector<const dom::Stop*> stops_;
 
-        std::unordered_map<graph::EdgeId, std::string_view> buses_names_;
-        std::unordered_map<graph::EdgeId, int> stops_counts_;
+        // The part of a bus route an edge rides, by edge id; walks
+        // have no bus.
+        static constexpr dom::BusId NO_BUS =
+            std::numeric_limits<dom::BusId>::max();
+        struct Ride {
+            dom::BusId bus = NO_BUS;
+            uint32_t from_position = 0;
+            uint32_t to_position = 0;
+        };
+        std::vector<Ride> rides_;
+
+        geo::SpatialIndex stops_index_;
 
         std::unique_ptr<graph::Router<double>> router_;
 
-        void AddEdges(const dom::Bus* bus, const TransportCatalogue& db);
+        // The catalogue the edges are built from. The timetable router
+        // is built from it on the first timetable query, as most
+        // requests need no timetable.
+        const TransportCatalogue* db_ = nullptr;
+        mutable std::mutex profile_router_mutex_;
+        mutable std::optional<ProfileRouter> profile_router_;
+
+        graph::Components components_;
+        mutable std::mutex centrality_mutex_;
+        mutable graph::Centrality centrality_;
+
+        void AddEdges(const dom::Bus& bus, const TransportCatalogue& db);
+        void AddWalkEdges();
+
+        std::vector<graph::DijkstraRouter<double>::Terminal>
+        GetWalkingTerminals(geo::Coordinates point,
+                            const ScenarioMask& mask) const;
+
+        bool IsEdgeOpen(graph::EdgeId edge_id,
+                        const ScenarioMask& mask) const;
+
+        // Safe to call from several threads at once.
+        const ProfileRouter& GetProfileRouter() const;
+
+        void AddTripActions(graph::EdgeId edge_id, double bus_wait_time,
+                            std::vector<dom::TripAction>& result) const;
     };
 
 } // namespace cat
\ No newline at end of file